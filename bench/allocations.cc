@@ -0,0 +1,177 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <distro/regex.hh>
+#include <distro/versions.hh>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+
+#include "generator.hh"
+
+// Every allocation of the process is counted, so the benchmarks below can
+// tell how many of them reach the heap with and without an arena. The
+// aligned forms are needed as well; std::pmr::new_delete_resource() uses
+// them for everything it allocates.
+namespace {
+	std::atomic<std::int64_t> heap_allocations{0};
+
+	void* counted(std::size_t size, std::size_t alignment) {
+		heap_allocations.fetch_add(1, std::memory_order_relaxed);
+		if (!size) size = 1;
+		void* ptr = alignment <= alignof(std::max_align_t)
+		                ? std::malloc(size)
+		                : std::aligned_alloc(
+		                      alignment,
+		                      (size + alignment - 1) / alignment * alignment);
+		if (!ptr) throw std::bad_alloc{};
+		return ptr;
+	}
+}  // namespace
+
+void* operator new(std::size_t size) {
+	return counted(size, alignof(std::max_align_t));
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return counted(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+	std::free(ptr);
+}
+
+namespace {
+	using namespace std::literals;
+
+	struct throwing_errors : distro::errors {
+		[[noreturn]] void src_dir(std::error_code const& ec) const override {
+			throw std::system_error{ec};
+		}
+		[[noreturn]] void dst_dir(std::error_code const& ec) const override {
+			throw std::system_error{ec};
+		}
+		[[noreturn]] void version_missing(
+		    distro::semver const&) const override {
+			throw std::runtime_error{"version missing"};
+		}
+	};
+
+	throwing_errors const log{};
+	distro::StringSet const architectures{"windows-x86_64", "anywhere"};
+	std::vector<std::string_view> const extensions{"zip"sv, "tar.gz"sv};
+
+	distro::file_matcher const& matcher() {
+		static distro::file_matcher const result{
+		    bench::package_name, distro::regex::platforms(), extensions};
+		return result;
+	}
+
+	size_t count_of(benchmark::State const& state) {
+		return static_cast<size_t>(state.range(0));
+	}
+
+	// average number of heap allocations of an iteration
+	void set_counters(benchmark::State& state, std::int64_t allocations) {
+		state.counters["allocs"] = benchmark::Counter(
+		    static_cast<double>(allocations),
+		    benchmark::Counter::kAvgIterations);
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	// Resolves every version of the directory, one after another, with
+	// the resolution lists taken from the heap or from an arena released
+	// after each of them.
+	void resolve(benchmark::State& state, bool arena) {
+		auto const pkgs = distro::versions::read_packages(
+		    bench::release_dir(count_of(state)), architectures, matcher(),
+		    log);
+		std::vector<std::optional<distro::semver>> requested{};
+		for (auto const& [version, run] : pkgs)
+			requested.emplace_back(version);
+
+		// released, the arena goes back to this buffer instead of asking
+		// the heap for a new one
+		static std::array<std::byte, 64 * 1024> storage;
+		std::pmr::monotonic_buffer_resource buffer{storage.data(),
+		                                           storage.size()};
+		std::pmr::memory_resource* resource =
+		    arena ? &buffer : std::pmr::get_default_resource();
+
+		std::int64_t allocations{};
+		for (auto _ : state) {
+			auto const before =
+			    heap_allocations.load(std::memory_order_relaxed);
+			for (auto& version : requested) {
+				auto selected = pkgs.find_selected(version, log);
+				auto comps = pkgs.components(selected, nullptr, resource);
+				comps.select();
+				benchmark::DoNotOptimize(comps);
+				buffer.release();
+			}
+			allocations += heap_allocations.load(std::memory_order_relaxed) -
+			               before;
+		}
+		state.counters["resolves"] = benchmark::Counter(
+		    static_cast<double>(requested.size()),
+		    benchmark::Counter::kDefaults);
+		set_counters(state, allocations);
+	}
+
+	void resolve_default(benchmark::State& state) { resolve(state, false); }
+	void resolve_arena(benchmark::State& state) { resolve(state, true); }
+
+	// Scans the directory and resolves the newest version, with the whole
+	// set allocated from the heap or from an arena dropped at once.
+	void scan_and_resolve(benchmark::State& state, bool arena) {
+		auto const& dir = bench::release_dir(count_of(state));
+
+		std::int64_t allocations{};
+		for (auto _ : state) {
+			auto const before =
+			    heap_allocations.load(std::memory_order_relaxed);
+			{
+				std::pmr::monotonic_buffer_resource buffer{1024 * 1024};
+				std::pmr::memory_resource* resource =
+				    arena ? &buffer : std::pmr::get_default_resource();
+
+				auto const pkgs = distro::versions::read_packages(
+				    dir, architectures, matcher(), log, nullptr, resource);
+				std::optional<distro::semver> requested{};
+				auto selected = pkgs.find_selected(requested, log);
+				auto comps = pkgs.components(selected, nullptr, resource);
+				comps.select();
+				benchmark::DoNotOptimize(comps);
+			}
+			allocations += heap_allocations.load(std::memory_order_relaxed) -
+			               before;
+		}
+		set_counters(state, allocations);
+	}
+
+	void scan_and_resolve_default(benchmark::State& state) {
+		scan_and_resolve(state, false);
+	}
+
+	void scan_and_resolve_arena(benchmark::State& state) {
+		scan_and_resolve(state, true);
+	}
+
+	void directory_sizes(benchmark::internal::Benchmark* bench) {
+		bench->Arg(1'000)->Arg(10'000)->Arg(100'000);
+		bench->Unit(benchmark::kMillisecond);
+	}
+
+	BENCHMARK(resolve_default)->Apply(directory_sizes);
+	BENCHMARK(resolve_arena)->Apply(directory_sizes);
+	BENCHMARK(scan_and_resolve_default)->Apply(directory_sizes);
+	BENCHMARK(scan_and_resolve_arena)->Apply(directory_sizes);
+}  // namespace
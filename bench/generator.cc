@@ -0,0 +1,158 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "generator.hh"
+
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string_view>
+#include <unordered_set>
+
+namespace bench {
+	namespace {
+		struct platform {
+			char const* name;
+			char const* ext;
+		};
+
+		constexpr platform platforms[] = {
+		    {"windows-x86_64", "zip"},
+		    {"windows-x86_32", "zip"},
+		    {"ubuntu18-x86_64", "tar.gz"},
+		    {"anywhere", "zip"},
+		};
+
+		constexpr char const* components[] = {"comp", "tools", "doc",
+		                                      "source"};
+		constexpr char const* prereleases[] = {"alpha", "beta", "beta.2",
+		                                       "rc.1", "rc.2"};
+		constexpr char const* noise[] = {".sha256", ".txt", ".log", ".msi"};
+
+		template <typename T, size_t N>
+		T const& pick(std::mt19937& rng, T const (&items)[N]) {
+			return items[rng() % N];
+		}
+
+		std::string archive_name(std::mt19937& rng, char const* pkg_name) {
+			auto name = std::string{pkg_name} + '-';
+			name += std::to_string(rng() % 20) + '.' +
+			        std::to_string(rng() % 10) + '.' +
+			        std::to_string(rng() % 30);
+			if (rng() % 10 < 3) {
+				name += '-';
+				name += pick(rng, prereleases);
+			}
+
+			auto const& pltfm = pick(rng, platforms);
+			name += '-';
+			name += pltfm.name;
+
+			auto const kind = rng() % 20;
+			if (kind >= 8) {
+				name += '-';
+				name += pick(rng, components);
+				if (kind >= 17) {
+					name += '-' + std::to_string(rng() % 3) + '.' +
+					        std::to_string(rng() % 12) + '.' +
+					        std::to_string(rng() % 5);
+				}
+			}
+
+			name += '.';
+			name += pltfm.ext;
+			return name;
+		}
+
+		// <major>/<major>.<minor> for the archives of package_name, empty
+		// for anything else
+		fs::path version_dir(std::string_view name) {
+			std::string_view const prefix = package_name;
+			if (!name.starts_with(prefix) || name.size() <= prefix.size() ||
+			    name[prefix.size()] != '-')
+				return {};
+			name.remove_prefix(prefix.size() + 1);
+
+			auto const dot = name.find('.');
+			auto const major = std::string{name.substr(0, dot)};
+			name.remove_prefix(dot + 1);
+			auto const minor = std::string{name.substr(0, name.find('.'))};
+			return fs::path{major} / (major + '.' + minor);
+		}
+
+		class directory {
+		public:
+			directory(size_t count, bool tree)
+			    : path_{fs::temp_directory_path() /
+			            ("distro-bench-" + std::string{tree ? "tree-" : ""} +
+			             std::to_string(count) + '-' +
+			             std::to_string(std::random_device{}()))} {
+				fs::create_directories(path_);
+				for (auto const& name : synthetic_names(count)) {
+					auto dir = path_;
+					if (tree) {
+						dir /= version_dir(name);
+						fs::create_directories(dir);
+					}
+					std::ofstream{dir / name};
+				}
+
+				using namespace std::chrono_literals;
+				fs::last_write_time(
+				    path_, fs::file_time_type::clock::now() - 1h);
+			}
+
+			~directory() {
+				std::error_code ec;
+				fs::remove_all(path_, ec);
+			}
+
+			directory(directory const&) = delete;
+			directory& operator=(directory const&) = delete;
+
+			fs::path const& path() const noexcept { return path_; }
+
+		private:
+			fs::path path_;
+		};
+	}  // namespace
+
+	std::vector<std::string> synthetic_names(size_t count, unsigned seed) {
+		std::mt19937 rng{seed};
+		std::unordered_set<std::string> unique{};
+		std::vector<std::string> names{};
+		names.reserve(count);
+
+		while (names.size() < count) {
+			std::string name{};
+			auto const kind = rng() % 20;
+			if (kind < 15) {
+				name = archive_name(rng, package_name);
+			} else if (kind < 18) {
+				name = archive_name(rng, "my-other-app");
+			} else {
+				name = archive_name(rng, package_name) + pick(rng, noise);
+			}
+
+			if (unique.insert(name).second) names.push_back(std::move(name));
+		}
+
+		return names;
+	}
+
+	fs::path const& release_dir(size_t count) {
+		static std::map<size_t, directory> dirs{};
+		auto it = dirs.find(count);
+		if (it == dirs.end()) it = dirs.try_emplace(count, count, false).first;
+		return it->second.path();
+	}
+
+	fs::path const& release_tree(size_t count) {
+		static std::map<size_t, directory> dirs{};
+		auto it = dirs.find(count);
+		if (it == dirs.end()) it = dirs.try_emplace(count, count, true).first;
+		return it->second.path();
+	}
+}  // namespace bench
@@ -0,0 +1,32 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace bench {
+	namespace fs = std::filesystem;
+
+	inline constexpr auto package_name = "my-awesome-app";
+
+	// Names of a synthetic release directory: archives of package_name for
+	// the platforms from distro::regex::platforms(), with main archives,
+	// components with and without own versions, some prereleases, mixed
+	// with archives of other packages, checksums and logs. Same count and
+	// seed always give the same names.
+	std::vector<std::string> synthetic_names(size_t count,
+	                                         unsigned seed = 2021);
+
+	// Directory filled with empty files named by synthetic_names, created
+	// on first use for each count and removed at exit. Its mtime is moved
+	// to the past, so scan indices treat it as settled.
+	fs::path const& release_dir(size_t count);
+
+	// Same names as release_dir, with the archives of package_name sorted
+	// into <major>/<major>.<minor> version directories.
+	fs::path const& release_tree(size_t count);
+}  // namespace bench
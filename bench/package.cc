@@ -0,0 +1,45 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <distro/package.hh>
+#include <distro/regex.hh>
+
+#include "generator.hh"
+
+namespace {
+	using namespace std::literals;
+
+	std::vector<std::string_view> const extensions{"zip"sv, "tar.gz"sv};
+
+	template <typename Matcher>
+	void from_string(benchmark::State& state, Matcher const& matcher) {
+		auto const names = bench::synthetic_names(1000);
+		distro::symbol_table table{};
+		for (auto _ : state) {
+			for (auto const& name : names) {
+				benchmark::DoNotOptimize(
+				    distro::package::from_string(name, matcher, table));
+			}
+		}
+		state.SetItemsProcessed(state.iterations() *
+		                        static_cast<int64_t>(names.size()));
+	}
+
+	void package_from_string_regex(benchmark::State& state) {
+		from_string(state,
+		            distro::build_file_matcher(bench::package_name,
+		                                       distro::regex::platforms(),
+		                                       extensions));
+	}
+	BENCHMARK(package_from_string_regex);
+
+	void package_from_string_file_matcher(benchmark::State& state) {
+		from_string(state,
+		            distro::file_matcher{bench::package_name,
+		                                 distro::regex::platforms(),
+		                                 extensions});
+	}
+	BENCHMARK(package_from_string_file_matcher);
+}  // namespace
@@ -0,0 +1,97 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <distro/semver.hh>
+
+#include <algorithm>
+#include <random>
+
+#include "generator.hh"
+#include "semver_regex.hh"
+
+namespace {
+	std::vector<std::string> version_strings(size_t count) {
+		std::mt19937 rng{2021};
+		static constexpr char const* prereleases[] = {
+		    "alpha", "alpha.1", "beta", "beta.2", "rc.1", "rc.2", "rc.10"};
+
+		std::vector<std::string> result{};
+		result.reserve(count);
+		for (size_t index = 0; index < count; ++index) {
+			auto ver = std::to_string(rng() % 20) + '.' +
+			           std::to_string(rng() % 10) + '.' +
+			           std::to_string(rng() % 30);
+			if (rng() % 10 < 3) {
+				ver += '-';
+				ver += prereleases[rng() % std::size(prereleases)];
+			}
+			result.push_back(std::move(ver));
+		}
+		return result;
+	}
+
+	std::vector<distro::semver> parsed(std::vector<std::string> const& strs) {
+		std::vector<distro::semver> result{};
+		result.reserve(strs.size());
+		for (auto const& str : strs)
+			result.push_back(*distro::semver::from_string(str));
+		return result;
+	}
+
+	void semver_from_string(benchmark::State& state) {
+		auto const strings = version_strings(1000);
+		for (auto _ : state) {
+			for (auto const& str : strings)
+				benchmark::DoNotOptimize(distro::semver::from_string(str));
+		}
+		state.SetItemsProcessed(state.iterations() *
+		                        static_cast<int64_t>(strings.size()));
+	}
+	BENCHMARK(semver_from_string);
+
+	// the std::regex parser from_string replaced, on the same strings
+	void semver_from_string_regex(benchmark::State& state) {
+		auto const strings = version_strings(1000);
+		for (auto _ : state) {
+			for (auto const& str : strings)
+				benchmark::DoNotOptimize(tests::semver_from_regex(str));
+		}
+		state.SetItemsProcessed(state.iterations() *
+		                        static_cast<int64_t>(strings.size()));
+	}
+	BENCHMARK(semver_from_string_regex);
+
+	void semver_less(benchmark::State& state) {
+		auto const versions = parsed(version_strings(1000));
+		for (auto _ : state) {
+			size_t less{};
+			for (size_t index = 1; index < versions.size(); ++index)
+				less += versions[index - 1] < versions[index];
+			benchmark::DoNotOptimize(less);
+		}
+		state.SetItemsProcessed(state.iterations() *
+		                        static_cast<int64_t>(versions.size() - 1));
+	}
+	BENCHMARK(semver_less);
+
+	void semver_sort(benchmark::State& state) {
+		auto const versions =
+		    parsed(version_strings(static_cast<size_t>(state.range(0))));
+		std::vector<distro::semver const*> order{};
+		for (auto _ : state) {
+			state.PauseTiming();
+			order.clear();
+			for (auto const& ver : versions)
+				order.push_back(&ver);
+			state.ResumeTiming();
+
+			std::sort(order.begin(), order.end(),
+			          [](auto lhs, auto rhs) { return *lhs < *rhs; });
+			benchmark::DoNotOptimize(order.data());
+		}
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+	BENCHMARK(semver_sort)->Arg(100'000)->Unit(benchmark::kMillisecond);
+}  // namespace
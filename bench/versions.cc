@@ -0,0 +1,219 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <benchmark/benchmark.h>
+#include <distro/regex.hh>
+#include <distro/versions.hh>
+
+#include <chrono>
+#include <stdexcept>
+
+#include "generator.hh"
+
+namespace {
+	namespace fs = std::filesystem;
+	using namespace std::literals;
+
+	struct throwing_errors : distro::errors {
+		[[noreturn]] void src_dir(std::error_code const& ec) const override {
+			throw std::system_error{ec};
+		}
+		[[noreturn]] void dst_dir(std::error_code const& ec) const override {
+			throw std::system_error{ec};
+		}
+		[[noreturn]] void version_missing(
+		    distro::semver const&) const override {
+			throw std::runtime_error{"version missing"};
+		}
+	};
+
+	throwing_errors const log{};
+	distro::StringSet const architectures{"windows-x86_64", "anywhere"};
+	std::vector<std::string_view> const extensions{"zip"sv, "tar.gz"sv};
+
+	distro::file_matcher const& matcher() {
+		static distro::file_matcher const result{
+		    bench::package_name, distro::regex::platforms(), extensions};
+		return result;
+	}
+
+	distro::regex_matcher const& regex() {
+		static distro::regex_matcher const result = distro::build_file_matcher(
+		    bench::package_name, distro::regex::platforms(), extensions);
+		return result;
+	}
+
+	size_t count_of(benchmark::State const& state) {
+		return static_cast<size_t>(state.range(0));
+	}
+
+	void set_items(benchmark::State& state) {
+		state.SetItemsProcessed(state.iterations() * state.range(0));
+	}
+
+	void read_packages_regex(benchmark::State& state) {
+		auto const& dir = bench::release_dir(count_of(state));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(distro::versions::read_packages(
+			    dir, architectures, regex(), log));
+		}
+		set_items(state);
+	}
+
+	void read_packages_regex_prefiltered(benchmark::State& state) {
+		distro::directory_source const source{
+		    bench::release_dir(count_of(state)),
+		    distro::name_prefilter{bench::package_name, extensions}};
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(distro::versions::read_packages(
+			    source, architectures, regex(), log));
+		}
+		set_items(state);
+	}
+
+	void read_packages_file_matcher(benchmark::State& state) {
+		auto const& dir = bench::release_dir(count_of(state));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(distro::versions::read_packages(
+			    dir, architectures, matcher(), log));
+		}
+		set_items(state);
+	}
+
+	void read_selected(benchmark::State& state) {
+		auto const& dir = bench::release_dir(count_of(state));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(distro::versions::read_selected(
+			    dir, architectures, std::nullopt, matcher(), log));
+		}
+		set_items(state);
+	}
+
+	// time from the start of the scan to the first archive settled
+	struct timing_sink : distro::package_sink {
+		std::chrono::steady_clock::time_point start{};
+		std::optional<std::chrono::steady_clock::duration> first{};
+
+		void settled(fs::path const&) override {
+			if (!first) first = std::chrono::steady_clock::now() - start;
+		}
+	};
+
+	// Streams the directory for the newest version, requested explicitly,
+	// so that its packages are settled during the scan. The "first_ms"
+	// counter is how soon the first archive could be worked on.
+	void stream_selected(benchmark::State& state) {
+		auto const& dir = bench::release_dir(count_of(state));
+		std::optional<distro::semver> requested{};
+		{
+			auto const pkgs = distro::versions::read_selected(
+			    dir, architectures, std::nullopt, matcher(), log);
+			pkgs.find_selected(requested, log);
+		}
+
+		std::chrono::duration<double, std::milli> first{};
+		for (auto _ : state) {
+			timing_sink sink{};
+			sink.start = std::chrono::steady_clock::now();
+			benchmark::DoNotOptimize(distro::versions::stream_selected(
+			    dir, architectures, requested, matcher(), sink, log));
+			if (sink.first) first += *sink.first;
+		}
+		state.counters["first_ms"] = benchmark::Counter(
+		    first.count(), benchmark::Counter::kAvgIterations);
+		set_items(state);
+	}
+
+	void read_tree(benchmark::State& state) {
+		auto const& dir = bench::release_tree(count_of(state));
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(distro::versions::read_tree(
+			    dir, architectures, matcher(), log));
+		}
+		set_items(state);
+	}
+
+	void read_tree_selected(benchmark::State& state) {
+		auto const& dir = bench::release_tree(count_of(state));
+		distro::StringSet const components{"comp", "tools", "doc", "source"};
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(distro::versions::read_tree_selected(
+			    dir, architectures, std::nullopt, components, matcher(),
+			    log));
+		}
+		set_items(state);
+	}
+
+	void read_cached(benchmark::State& state, bool warm) {
+		auto const& dir = bench::release_dir(count_of(state));
+		auto const index = dir.parent_path() /
+		                   (dir.filename().string() + ".index");
+		std::error_code ec;
+		fs::remove(index, ec);
+		if (warm) {
+			distro::versions::read_cached(dir, index, architectures,
+			                              matcher(), log);
+		}
+
+		for (auto _ : state) {
+			if (!warm) {
+				state.PauseTiming();
+				fs::remove(index, ec);
+				state.ResumeTiming();
+			}
+			benchmark::DoNotOptimize(distro::versions::read_cached(
+			    dir, index, architectures, matcher(), log));
+		}
+		fs::remove(index, ec);
+		set_items(state);
+	}
+
+	void read_cached_cold(benchmark::State& state) {
+		read_cached(state, false);
+	}
+
+	void read_cached_warm(benchmark::State& state) {
+		read_cached(state, true);
+	}
+
+	void get_archives(benchmark::State& state) {
+		auto const& dir = bench::release_dir(count_of(state));
+		auto const pkgs = distro::versions::read_packages(dir, architectures,
+		                                                  matcher(), log);
+		for (auto _ : state) {
+			std::optional<distro::semver> requested{};
+			auto selected = pkgs.find_selected(requested, log);
+			benchmark::DoNotOptimize(
+			    pkgs.components(selected).get_archives());
+		}
+		set_items(state);
+	}
+
+	void resolve_all(benchmark::State& state) {
+		auto const& dir = bench::release_dir(count_of(state));
+		auto const pkgs = distro::versions::read_packages(dir, architectures,
+		                                                  matcher(), log);
+		for (auto _ : state) {
+			benchmark::DoNotOptimize(pkgs.resolve_all());
+		}
+		set_items(state);
+	}
+
+	void directory_sizes(benchmark::internal::Benchmark* bench) {
+		bench->Arg(1'000)->Arg(10'000)->Arg(100'000);
+		bench->Unit(benchmark::kMillisecond);
+	}
+
+	BENCHMARK(read_packages_regex)->Apply(directory_sizes);
+	BENCHMARK(read_packages_regex_prefiltered)->Apply(directory_sizes);
+	BENCHMARK(read_packages_file_matcher)->Apply(directory_sizes);
+	BENCHMARK(read_selected)->Apply(directory_sizes);
+	BENCHMARK(stream_selected)->Apply(directory_sizes);
+	BENCHMARK(read_tree)->Apply(directory_sizes);
+	BENCHMARK(read_tree_selected)->Apply(directory_sizes);
+	BENCHMARK(read_cached_cold)->Apply(directory_sizes);
+	BENCHMARK(read_cached_warm)->Apply(directory_sizes);
+	BENCHMARK(get_archives)->Apply(directory_sizes);
+	BENCHMARK(resolve_all)->Apply(directory_sizes);
+}  // namespace
@@ -0,0 +1,71 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include <distro/errors.hh>
+#include <distro/observer.hh>
+
+namespace distro {
+	namespace fs = std::filesystem;
+
+	enum class extract_errc {
+		// none of tar, zip, gzip, bzip2 or xz
+		unknown_format = 1,
+		// compressed with a library missing from this build
+		unsupported_format,
+		damaged_archive,
+		// sparse files, encrypted or unknown zip methods
+		unsupported_entry,
+		// absolute path or one with "..", a link pointing outside or
+		// through another link, or an entry inside a link
+		unsafe_path,
+	};
+
+	std::error_category const& extract_category() noexcept;
+	inline std::error_code make_error_code(extract_errc code) noexcept {
+		return {static_cast<int>(code), extract_category()};
+	}
+
+	// Unpacks the archives into dstdir, on at most `threads` workers (zero
+	// for one per hardware thread), each archive on one of them. Archives
+	// are recognized by their contents: tar, zip and tar compressed with
+	// whatever of gzip, bzip2 and xz this build has.
+	//
+	// If more than one archive has a file under the same path, the one
+	// listed first wins, no matter which worker finishes first; for the
+	// list from get_archives, the packages of the selected version cover
+	// the older component providers, which cover their own older ones.
+	// Each file is written next to its place and renamed over it.
+	//
+	// Nothing is written through a link, be it one from the archives or
+	// one already in dstdir, and link targets may not go through other
+	// links, so that no chain of them leads outside of dstdir. Hard links
+	// are copies of what the same archive stored under their target.
+	//
+	// Archive, which cannot be opened, goes to log.src_dir, any other
+	// problem to log.dst_dir; both are reported once all workers are done,
+	// for the first failing archive of the list. Exceptions thrown while
+	// unpacking are rethrown the same way.
+	void extract(std::span<fs::path const> archives,
+	             fs::path const& dstdir,
+	             errors const& log,
+	             unsigned threads = 0,
+	             observer* obs = nullptr);
+
+	// extensions of the archives extract can unpack in this build, ready
+	// for the file_matcher
+	std::span<std::string_view const> extractable_extensions() noexcept;
+}  // namespace distro
+
+namespace std {
+	template <>
+	struct is_error_code_enum<distro::extract_errc> : true_type {};
+}  // namespace std
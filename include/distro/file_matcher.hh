@@ -0,0 +1,64 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <distro/name_prefilter.hh>
+#include <distro/token_trie.hh>
+
+namespace distro {
+	// captures of a matched filename, all pointing into the matched view
+	struct file_match {
+		std::string_view version;
+		std::string_view arch;
+		std::optional<std::string_view> comp{};
+		std::optional<std::string_view> compver{};
+	};
+
+	// will match the same filenames as regex from build_file_matcher:
+	//    <package_name>-<semver>-<platform>[-<component>[-<ver>]].<ext>
+	// and report the same four captures, without running a regex engine:
+	//  - package_name is compared as a literal prefix,
+	//  - ext is looked up from the end of the filename in a trie of the
+	//    reversed extensions, rejecting most foreign files up front,
+	//  - platform is looked up in a trie of the platforms; if more than one
+	//    platform could match at given place, they are tried in the order of
+	//    the argument, the same as the alternation would be.
+	class file_matcher {
+	public:
+		file_matcher(std::string_view package_name,
+		             std::vector<std::string_view> const& platforms,
+		             std::vector<std::string_view> const& extensions);
+
+		std::optional<file_match> match(std::string_view filename) const;
+
+		// hash of the arguments, for telling apart data produced by matchers
+		// built for different package names, platforms or extensions
+		std::uint64_t fingerprint() const noexcept { return fingerprint_; }
+
+		// prefilter built from the same package name and extensions, for
+		// the package sources
+		name_prefilter const& prefilter() const noexcept { return prefilter_; }
+
+	private:
+		std::optional<file_match> match_platform(std::string_view filename,
+		                                         size_t separator) const;
+		std::optional<file_match> match_component(std::string_view filename,
+		                                          size_t pos) const;
+		bool is_extension_at(std::string_view filename, size_t pos) const;
+
+		std::string name_;
+		token_trie platforms_{};
+		token_trie extensions_{};
+		std::uint64_t fingerprint_{};
+		name_prefilter prefilter_;
+	};
+}  // namespace distro
@@ -0,0 +1,45 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace distro {
+	// Cheap first stage of the name matching: rejects the names, which do
+	// not start with "<package_name>-" or do not end with any of
+	// ".<extension>", before the regex or file_matcher and any semver
+	// parsing runs. Never rejects a name the matcher built from the same
+	// arguments would accept.
+	//
+	// Compares with SSE2 or AVX2, whichever the build targets, one vector
+	// load per name and pattern; short names and patterns longer than the
+	// vector fall back to plain comparisons.
+	class name_prefilter {
+	public:
+		name_prefilter(std::string_view package_name,
+		               std::vector<std::string_view> const& extensions);
+
+		bool accepts(std::string_view name) const noexcept;
+
+	private:
+		// longest pattern compared with a single vector load
+		static constexpr size_t max_width = 32;
+		using pattern = std::array<char, max_width>;
+
+		bool has_prefix(std::string_view name) const noexcept;
+		bool has_suffix(std::string_view name) const noexcept;
+
+		std::string prefix_;
+		std::vector<std::string> suffixes_;
+		// prefix aligned to the front, suffixes aligned to the back of the
+		// patterns, the rest zeroed
+		pattern prefix_pattern_{};
+		std::vector<pattern> suffix_patterns_{};
+		size_t min_size_{};
+	};
+}  // namespace distro
@@ -0,0 +1,78 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+
+namespace distro {
+	namespace fs = std::filesystem;
+
+	// counters of a single directory scan; each entry, which is not
+	// a directory, ends up in exactly one of the six counters from
+	// prefilter_rejections to packages_kept (names turned down by the
+	// prefilter are not checked for being directories)
+	struct scan_stats {
+		size_t entries{};
+		// stat calls made to tell directories from files, for entries the
+		// directory listing did not give the type of; counted only where
+		// the entries are read with getdents64
+		size_t directory_checks{};
+		// rejected by the name_prefilter of the source, if there was one
+		size_t prefilter_rejections{};
+		// rejected by the regex or the file_matcher
+		size_t name_rejections{};
+		// matched, but the version or component version is not a semver
+		size_t semver_failures{};
+		// inside a version directory of a tree, but of a version, which
+		// does not start with the name of the directory
+		size_t misplaced{};
+		size_t arch_rejections{};
+		// handed over to the resulting set; read_selected may still drop
+		// the ones, which cannot be used by the query
+		size_t packages_kept{};
+		// version directories of a tree, which were not read, since
+		// nothing the query could use is inside
+		size_t subtrees_pruned{};
+
+		scan_stats& operator+=(scan_stats const& other) noexcept;
+		// part of the entries the prefilter turned down, from 0 to 1
+		double prefilter_rejection_rate() const noexcept;
+	};
+
+	enum class phase {
+		scan,        // reading the directory and matching the names
+		index,       // sorting the packages and building the version index
+		select,      // find_selected
+		components,  // components
+		archives,    // comp_list::get_archives
+		extract,     // extract
+	};
+	inline constexpr size_t phase_count = 6;
+
+	// Receives the numbers from read_packages, read_selected,
+	// find_selected, components, get_archives and extract. None of them is
+	// reported, nor is the clock read, if no observer is attached.
+	struct observer {
+		using duration = std::chrono::steady_clock::duration;
+
+		virtual ~observer();
+		virtual void scanned(fs::path const& srcdir,
+		                     scan_stats const& stats) = 0;
+		virtual void timed(phase which, duration elapsed) = 0;
+	};
+
+	// observer summing up everything it was told, ready to be exported
+	struct statistics : observer {
+		scan_stats scan{};
+		std::array<duration, phase_count> time{};
+		std::array<size_t, phase_count> calls{};
+
+		void scanned(fs::path const& srcdir, scan_stats const& stats) override;
+		void timed(phase which, duration elapsed) override;
+	};
+}  // namespace distro
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <distro/file_matcher.hh>
 #include <distro/semver.hh>
+#include <distro/symbols.hh>
+#include <cstdint>
 #include <filesystem>
+#include <memory_resource>
 #include <optional>
 #include <regex>
 #include <string>
@@ -14,18 +18,59 @@ namespace distro {
 	namespace fs = std::filesystem;
 
 	struct package {
+		// the name and versions come from one memory resource, usually
+		// the one of the versions object keeping the package
+		using allocator_type = semver::allocator_type;
+
+		// architecture and component names are symbols of the table the
+		// package was read with, see versions::symbols()
 		struct component {
-			std::string name;
+			symbol name;
 			std::optional<semver> version;
 		};
-		fs::path archive{};
+		// name of the archive inside its source directory, in UTF-8; the
+		// full path is built by versions only for the returned archives
+		std::pmr::string filename{};
 		semver version{};
-		std::string arch;
+		symbol arch{};
 		std::optional<component> comp{};
-		bool selected{false};
+		// index of the source directory inside versions, for sets read
+		// from more than one root
+		std::uint32_t root{};
+
+		package() = default;
+		explicit package(allocator_type const& alloc);
+		package(package const&) = default;
+		package(package&&) = default;
+		package(package const& other, allocator_type const& alloc);
+		package(package&& other, allocator_type const& alloc);
+		package& operator=(package const&) = default;
+		package& operator=(package&&) = default;
+
+		allocator_type get_allocator() const noexcept {
+			return filename.get_allocator();
+		}
 
-		static std::optional<package> from_string(fs::path const& archive,
-		                                          std::string_view view,
-		                                          std::regex const& matcher);
+		static std::optional<package> from_string(
+		    std::string_view view,
+		    std::regex const& matcher,
+		    symbol_table& table,
+		    allocator_type const& alloc = {});
+		static std::optional<package> from_string(
+		    std::string_view view,
+		    file_matcher const& matcher,
+		    symbol_table& table,
+		    allocator_type const& alloc = {});
+		// the captures from_string would build the package from, pointing
+		// into the view
+		static std::optional<file_match> match(std::string_view view,
+		                                       std::regex const& matcher);
+		static std::optional<file_match> match(std::string_view view,
+		                                       file_matcher const& matcher);
+		static std::optional<package> from_match(
+		    std::string_view view,
+		    file_match const& match,
+		    symbol_table& table,
+		    allocator_type const& alloc = {});
 	};
 }  // namespace distro
@@ -0,0 +1,48 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <distro/file_matcher.hh>
+#include <distro/token_trie.hh>
+
+namespace distro {
+	struct package_match {
+		// index of the package name in the matcher
+		size_t package;
+		file_match captures;
+	};
+
+	// Matches the archives of several packages sharing one directory. The
+	// package name is looked up in a trie, then the filename goes through
+	// the file_matcher of that package. If more than one name is
+	// a prefix of the filename (e.g. "app" and "app-tools"), shorter
+	// names are tried first.
+	class package_matcher {
+	public:
+		package_matcher(std::vector<std::string_view> const& package_names,
+		                std::vector<std::string_view> const& platforms,
+		                std::vector<std::string_view> const& extensions);
+
+		std::optional<package_match> match(std::string_view filename) const;
+
+		size_t size() const noexcept { return matchers_.size(); }
+		std::string_view name(size_t index) const noexcept {
+			return names_[index];
+		}
+		file_matcher const& matcher(size_t index) const noexcept {
+			return matchers_[index];
+		}
+
+	private:
+		std::vector<std::string> names_;
+		std::vector<file_matcher> matchers_;
+		token_trie prefixes_;
+	};
+}  // namespace distro
@@ -0,0 +1,29 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <filesystem>
+
+#include <distro/package.hh>
+#include <distro/symbols.hh>
+
+namespace distro {
+	namespace fs = std::filesystem;
+
+	// Receives what versions::stream_selected finds while the scan is
+	// still going, on the thread scanning. Anything slow, like copying an
+	// archive, should be handed over to another thread.
+	struct package_sink {
+		virtual ~package_sink();
+		// Each package accepted by the matcher and the architectures, as
+		// soon as it is matched, whether the query uses it or not. The
+		// package and the table naming its symbols are only valid during
+		// the call.
+		virtual void matched(package const& pkg, symbol_table const& table);
+		// Archive the query is certain to return. Each of them is settled
+		// once, in the order of comp_list::get_archives.
+		virtual void settled(fs::path const& archive) = 0;
+	};
+}  // namespace distro
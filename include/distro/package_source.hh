@@ -0,0 +1,79 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+#include <distro/name_prefilter.hh>
+#include <distro/observer.hh>
+
+namespace distro {
+	namespace fs = std::filesystem;
+
+	// Where the names of the archives come from. The names are relative
+	// to root(), which is used only to build the paths of the archives
+	// finally returned. With a prefilter, only the names it accepts are
+	// visited.
+	class package_source {
+	public:
+		using visitor = std::function<void(std::string_view)>;
+
+		virtual ~package_source();
+
+		fs::path const& root() const noexcept { return root_; }
+		name_prefilter const* prefilter() const noexcept {
+			return prefilter_ ? &*prefilter_ : nullptr;
+		}
+
+		// calls visit for each name, which could be an archive; the view
+		// is only valid during the call
+		virtual std::error_code for_each_name(visitor const& visit,
+		                                      scan_stats& stats) const = 0;
+
+	protected:
+		package_source(fs::path root, std::optional<name_prefilter> prefilter)
+		    : root_{std::move(root)}, prefilter_{std::move(prefilter)} {}
+
+	private:
+		fs::path root_;
+		std::optional<name_prefilter> prefilter_;
+	};
+
+	// entries of a directory, which are not directories themselves
+	class directory_source final : public package_source {
+	public:
+		explicit directory_source(
+		    fs::path srcdir,
+		    std::optional<name_prefilter> prefilter = std::nullopt)
+		    : package_source{std::move(srcdir), std::move(prefilter)} {}
+
+		std::error_code for_each_name(visitor const& visit,
+		                              scan_stats& stats) const override;
+	};
+
+	// Newline-delimited listing of the archives inside root, as published
+	// by an artifact store. The file is mapped for the time of the scan
+	// and the names are visited straight from the mapping, without asking
+	// the filesystem about any of them. Empty lines and carriage returns
+	// at line ends are skipped.
+	class manifest_source final : public package_source {
+	public:
+		manifest_source(fs::path manifest,
+		                fs::path root,
+		                std::optional<name_prefilter> prefilter = std::nullopt)
+		    : package_source{std::move(root), std::move(prefilter)}
+		    , manifest_{std::move(manifest)} {}
+
+		std::error_code for_each_name(visitor const& visit,
+		                              scan_stats& stats) const override;
+
+	private:
+		fs::path manifest_;
+	};
+}  // namespace distro
@@ -4,8 +4,13 @@
 
 #pragma once
 
+#include <optional>
 #include <regex>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+#include <distro/name_prefilter.hh>
 
 namespace distro {
 	using svmatch = std::match_results<std::string_view::const_iterator>;
@@ -18,6 +23,27 @@ namespace distro {
 		return {ptr, length};
 	}
 
+	// std::regex, which may also carry the name_prefilter built from the
+	// package name and extensions of build_file_matcher, so that scans
+	// with it get the prefilter the same way the file_matcher scans do.
+	// A name or extension using regex syntax, which the prefilter would
+	// take literally, and any other std::regex go without a prefilter.
+	class regex_matcher : public std::regex {
+	public:
+		regex_matcher(std::regex const& regex) : std::regex{regex} {}
+		regex_matcher(std::regex&& regex) : std::regex{std::move(regex)} {}
+		regex_matcher(std::regex&& regex, name_prefilter prefilter)
+		    : std::regex{std::move(regex)}
+		    , prefilter_{std::move(prefilter)} {}
+
+		std::optional<name_prefilter> const& prefilter() const noexcept {
+			return prefilter_;
+		}
+
+	private:
+		std::optional<name_prefilter> prefilter_{};
+	};
+
 	// will build a regex matching:
 	//    <package_name>-<semver>-<platform>[-<component>].<ext>
 	// where:
@@ -33,7 +59,9 @@ namespace distro {
 	//    archives building a single distribution.
 	//  - ext is an alternative between items in the argument, with the items's
 	//    dots escaped (e.g. "zip", "tar.gz" => "zip|tar\\.gz")
-	std::regex build_file_matcher(
+	// The result carries a name_prefilter for the package name and the
+	// extensions; assigned to a plain std::regex, it loses it.
+	regex_matcher build_file_matcher(
 	    std::string_view package_name,
 	    std::vector<std::string_view> const& platforms,
 	    std::vector<std::string_view> const& extensions);
@@ -0,0 +1,75 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+
+namespace distro {
+	// Formats of versions::comp_list::report. Each of them lists the
+	// components nobody provided and then every version with a package for
+	// the architectures of the query, oldest first, with its packages:
+	// main package first, then by component name and version.
+	enum class report_format {
+		// what debug_print shows, colored with ANSI escapes: selected
+		// version and its packages in cyan and green, other versions
+		// providing anything in darker shades, the rest in gray
+		ansi,
+		// one object:
+		//
+		//   {"missing": ["comp", ...],
+		//    "versions": [{"version": "1.2.3",
+		//                  "state": "selected" | "provider" | "unused",
+		//                  "packages": [{"file": "name.zip",
+		//                                "arch": "windows-x86_64",
+		//                                "component": null | "comp",
+		//                                "component_version": "1.0",
+		//                                "selected": true}, ...]}, ...]}
+		//
+		// "component_version" is there only for packages with one
+		json,
+		// stream of records, see report_record
+		binary,
+	};
+
+	// The binary report starts with the four bytes of report_magic and
+	// continues with records, each one a tag followed by its fields. Bytes
+	// and flags are single octets, counts are unsigned LEB128 and strings
+	// are a LEB128 length followed by that many bytes of UTF-8.
+	enum class report_record : std::uint8_t {
+		// no fields; always the last record
+		end = 0,
+		// string: component name
+		missing = 1,
+		// byte: report_state, flags: report_version_flags, string: version,
+		// count: number of package records following
+		version = 2,
+		// flags: report_package_flags, string: file name, string:
+		// architecture, then, if flagged, string: component name and
+		// string: component version
+		package = 3,
+	};
+
+	enum class report_state : std::uint8_t {
+		unused = 0,
+		// older version providing some of the components
+		provider = 1,
+		selected = 2,
+	};
+
+	namespace report_version_flags {
+		// packages of the version are built for more than one
+		// architecture
+		inline constexpr std::uint8_t mixed_arch = 0x01;
+	}  // namespace report_version_flags
+
+	namespace report_package_flags {
+		inline constexpr std::uint8_t selected = 0x01;
+		inline constexpr std::uint8_t component = 0x02;
+		inline constexpr std::uint8_t component_version = 0x04;
+	}  // namespace report_package_flags
+
+	// "DSR" and the version of the format
+	inline constexpr char report_magic[4] = {'D', 'S', 'R', '\x01'};
+}  // namespace distro
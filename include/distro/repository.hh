@@ -0,0 +1,120 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <stop_token>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <distro/errors.hh>
+#include <distro/file_matcher.hh>
+#include <distro/observer.hh>
+#include <distro/regex.hh>
+#include <distro/versions.hh>
+
+namespace distro {
+	// Source directory scanned once and then kept up to date. Each change
+	// is published as a new, immutable versions object; readers take the
+	// current one with snapshot(), never waiting for an update in
+	// progress, and keep using it for as long as they hold the pointer,
+	// whatever happens to the directory in the meantime.
+	//
+	// On Linux, a background thread follows the inotify events of the
+	// directory and applies the archives written and closed, moved in,
+	// deleted and moved out to the last set, rescanning the whole
+	// directory only if the kernel queue overflows. An archive still
+	// being uploaded is not seen until its writer closes it; links made
+	// in place are only seen by refresh(). Elsewhere, and after a failed
+	// watch, the set changes only on refresh().
+	//
+	// Only the directory is read incrementally. Each snapshot is a full
+	// copy of the packages with its own index, so publishing costs one
+	// pass over the whole set.
+	class repository {
+	public:
+		// The observer, if any, gets the numbers of the first scan only.
+		// Failing scan goes to log.src_dir. Failing to set up the watch
+		// does not: the set is served as if there was no watch, changing
+		// on refresh() only, and watch_error() tells why.
+		repository(fs::path srcdir,
+		           StringSet architectures,
+		           regex_matcher const& matcher,
+		           errors const& log,
+		           observer* obs = nullptr);
+		repository(fs::path srcdir,
+		           StringSet architectures,
+		           file_matcher const& matcher,
+		           errors const& log,
+		           observer* obs = nullptr);
+		~repository();
+		repository(repository const&) = delete;
+		repository& operator=(repository const&) = delete;
+
+		std::shared_ptr<versions const> snapshot() const noexcept {
+			return current_.load(std::memory_order_acquire);
+		}
+		// number of snapshots published so far, the first scan included
+		std::uint64_t generation() const noexcept {
+			return generation_.load(std::memory_order_acquire);
+		}
+
+		// rescans the whole directory and publishes the result
+		std::error_code refresh();
+		// why the background thread does not follow the directory, if it
+		// could not start or has stopped
+		std::error_code watch_error() const;
+
+	private:
+		using matcher_type =
+		    std::function<std::optional<file_match>(std::string_view)>;
+
+		repository(fs::path&& srcdir,
+		           StringSet&& architectures,
+		           matcher_type&& matcher,
+		           std::optional<name_prefilter>&& prefilter,
+		           errors const& log,
+		           observer* obs);
+
+		// called with update_mutex_ locked
+		std::error_code rescan(scan_stats& stats);
+		bool add(std::string_view name);
+		bool remove(std::string_view name);
+		void publish();
+		void watch(std::stop_token stop);
+
+		fs::path srcdir_;
+		StringSet architectures_;
+		matcher_type match_;
+		std::optional<name_prefilter> prefilter_;
+
+		// the state of the directory, owned by whoever holds the mutex:
+		// the packages sorted by version, in the order of arrival inside
+		// each version, and their names
+		mutable std::mutex update_mutex_{};
+		symbol_table table_{};
+		arch_filter filter_{};
+		std::pmr::vector<package> packages_{};
+		std::unordered_set<std::string> names_{};
+		std::error_code watch_error_{};
+
+		std::atomic<std::shared_ptr<versions const>> current_{};
+		std::atomic<std::uint64_t> generation_{};
+
+		// inotify descriptor and the one waking the thread up to stop
+		int watch_fd_{-1};
+		int wake_fd_{-1};
+		std::jthread watcher_{};
+	};
+}  // namespace distro
@@ -1,40 +1,128 @@
-// Copyright 2021 midnightBITS
-// Use of this source code is governed by a MIT-style license that can be
-// found in the LICENSE file.
-
-#pragma once
-
-#include <optional>
-#include <string>
-#include <variant>
-#include <vector>
-
-namespace distro {
-	class semver {
-	public:
-		class comp {
-			std::variant<unsigned, std::string> value;
-
-		public:
-			comp() = default;
-			comp(unsigned val) : value{val} {}
-			comp(std::string const& val) : value{val} {}
-			comp(std::string&& val) : value{std::move(val)} {}
-			std::string to_string() const;
-			bool operator<(comp const& rhs) const;
-			bool operator==(comp const& rhs) const;
-			static comp from_string(std::string_view comp);
-		};
-
-		unsigned major;
-		unsigned minor;
-		unsigned patch;
-		std::vector<comp> prerelease;
-		std::vector<std::string> meta;
-
-		std::string to_string() const;
-		bool operator<(semver const& rhs) const;
-		bool operator==(semver const& rhs) const;
-		static std::optional<semver> from_string(std::string_view view);
-	};
-}  // namespace distro
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace distro {
+	class semver {
+	public:
+		// all the strings and vectors of a version, its prerelease
+		// included, come from one memory resource
+		using allocator_type = std::pmr::polymorphic_allocator<>;
+
+		class comp {
+			std::variant<unsigned, std::pmr::string> value;
+
+		public:
+			using allocator_type = semver::allocator_type;
+
+			comp() = default;
+			explicit comp(allocator_type const&) {}
+			comp(unsigned val, allocator_type const& = {}) : value{val} {}
+			comp(std::string_view val, allocator_type const& alloc = {})
+			    : value{std::in_place_type<std::pmr::string>, val, alloc} {}
+			comp(comp const&) = default;
+			comp(comp&&) = default;
+			comp(comp const& other, allocator_type const& alloc);
+			comp(comp&& other, allocator_type const& alloc);
+			comp& operator=(comp const&) = default;
+			comp& operator=(comp&&) = default;
+
+			// the value, if the identifier is numeric, or its text;
+			// exactly one of them is not null
+			unsigned const* number() const noexcept {
+				return std::get_if<unsigned>(&value);
+			}
+			std::pmr::string const* text() const noexcept {
+				return std::get_if<std::pmr::string>(&value);
+			}
+
+			std::string to_string() const;
+			bool operator<(comp const& rhs) const;
+			bool operator==(comp const& rhs) const;
+			static comp from_string(std::string_view comp,
+			                        allocator_type const& alloc = {});
+
+		private:
+			friend class semver;
+		};
+
+		// Precomputed ordering of a version. The release is packed into one
+		// word, if each part fits in 21 bits, with lowest bit set for
+		// versions without prerelease; the prerelease is encoded into bytes
+		// comparable with memcmp: numbers as 0x01 with big-endian value,
+		// strings as 0x02 with the text and a NUL, the list ended with
+		// 0xFF, so that shorter list compares greater. Encodings not fitting
+		// the buffer are kept truncated; comparisons they cannot decide fall
+		// back to comparing the fields. A key, which no longer agrees with
+		// the numbers or with the count of prerelease identifiers, is
+		// ignored the same way.
+		class sort_key {
+		public:
+			bool packed() const noexcept { return flags_ & packed_flag; }
+			bool truncated() const noexcept { return flags_ & truncated_flag; }
+
+		private:
+			friend class semver;
+			static constexpr std::uint8_t packed_flag = 1;
+			static constexpr std::uint8_t truncated_flag = 2;
+
+			std::uint64_t release_{};
+			std::uint8_t flags_{};
+			std::uint8_t length_{};
+			std::uint8_t identifiers_{};
+			std::array<std::uint8_t, 21> prerelease_{};
+		};
+
+		unsigned major{};
+		unsigned minor{};
+		unsigned patch{};
+		std::pmr::vector<comp> prerelease{};
+		std::pmr::vector<std::pmr::string> meta{};
+		// Filled by the constructors and from_string. Changing the numbers,
+		// or adding and removing prerelease identifiers, makes comparisons
+		// fall back to the fields until update_key is called; replacing an
+		// identifier in place is not noticed, so call update_key after it.
+		sort_key key{};
+
+		semver() = default;
+		explicit semver(allocator_type const& alloc);
+		semver(unsigned major,
+		       unsigned minor,
+		       unsigned patch,
+		       allocator_type const& alloc = {});
+		semver(semver const&) = default;
+		semver(semver&&) = default;
+		semver(semver const& other, allocator_type const& alloc);
+		semver(semver&& other, allocator_type const& alloc);
+		semver& operator=(semver const&) = default;
+		semver& operator=(semver&&) = default;
+
+		allocator_type get_allocator() const noexcept {
+			return prerelease.get_allocator();
+		}
+
+		std::string to_string() const;
+		bool operator<(semver const& rhs) const;
+		bool operator==(semver const& rhs) const;
+		void update_key();
+		static std::optional<semver> from_string(
+		    std::string_view view,
+		    allocator_type const& alloc = {});
+
+	private:
+		int compare(semver const& rhs) const;
+		int compare_fields(semver const& rhs) const;
+		bool key_matches() const noexcept;
+	};
+}  // namespace distro
@@ -0,0 +1,122 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace distro {
+	using StringSet = std::unordered_set<std::string>;
+
+	// small integer standing for an architecture or component name
+	using symbol = std::uint32_t;
+
+	// Keeps each of the few distinct architecture and component names
+	// once and hands out their symbols, numbered from zero in the order
+	// of first appearance. Small tables are searched linearly, larger
+	// ones through a hash map.
+	class symbol_table {
+	public:
+		symbol_table() = default;
+		symbol_table(symbol_table const&);
+		symbol_table(symbol_table&&) = default;
+		symbol_table& operator=(symbol_table const&);
+		symbol_table& operator=(symbol_table&&) = default;
+
+		symbol intern(std::string_view name);
+		std::optional<symbol> find(std::string_view name) const noexcept;
+		std::string_view name(symbol id) const noexcept { return names_[id]; }
+		size_t size() const noexcept { return names_.size(); }
+
+	private:
+		void rebuild_index();
+
+		// deque, so that the index may view the names
+		std::deque<std::string> names_{};
+		std::unordered_map<std::string_view, symbol> index_{};
+	};
+
+	// set of symbols of one table, as a bitset
+	class symbol_set {
+	public:
+		using allocator_type = std::pmr::polymorphic_allocator<>;
+
+		symbol_set() = default;
+		explicit symbol_set(allocator_type const& alloc) : words_{alloc} {}
+		symbol_set(symbol_set const&) = default;
+		symbol_set(symbol_set&&) = default;
+		symbol_set(symbol_set const& other, allocator_type const& alloc)
+		    : words_{other.words_, alloc}, count_{other.count_} {}
+		symbol_set(symbol_set&& other, allocator_type const& alloc)
+		    : words_{std::move(other.words_), alloc}, count_{other.count_} {}
+		symbol_set& operator=(symbol_set const&) = default;
+		symbol_set& operator=(symbol_set&&) = default;
+
+		void insert(symbol id);
+		void erase(symbol id) noexcept;
+		bool contains(symbol id) const noexcept {
+			auto const word = id / bits;
+			return word < words_.size() &&
+			       (words_[word] >> (id % bits)) & 1;
+		}
+		bool empty() const noexcept { return !count_; }
+		void clear() noexcept {
+			std::fill(words_.begin(), words_.end(), std::uint64_t{});
+			count_ = 0;
+		}
+		size_t size() const noexcept { return count_; }
+
+		// calls visit(symbol) in ascending order
+		template <typename Visitor>
+		void for_each(Visitor&& visit) const {
+			for (size_t word = 0; word < words_.size(); ++word) {
+				for (auto bit = words_[word]; bit; bit &= bit - 1) {
+					auto const index =
+					    static_cast<size_t>(std::countr_zero(bit));
+					visit(static_cast<symbol>(word * bits + index));
+				}
+			}
+		}
+
+	private:
+		static constexpr size_t bits = 64;
+		std::pmr::vector<std::uint64_t> words_{};
+		size_t count_{};
+	};
+
+	// Architectures to accept, as symbols of one table, so that packages
+	// are checked with a bit test. An empty set of names accepts anything.
+	class arch_filter {
+	public:
+		using allocator_type = symbol_set::allocator_type;
+
+		arch_filter() = default;
+		// interns the names, for scans adding packages to the table later
+		arch_filter(StringSet const& architectures,
+		            symbol_table& table,
+		            allocator_type const& alloc = {});
+		// names not in the table cannot match any of its packages
+		arch_filter(StringSet const& architectures,
+		            symbol_table const& table,
+		            allocator_type const& alloc = {});
+
+		bool accepts(symbol arch) const noexcept {
+			return any_ || allowed_.contains(arch);
+		}
+
+	private:
+		bool any_{true};
+		symbol_set allowed_{};
+	};
+}  // namespace distro
@@ -0,0 +1,68 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace distro {
+	// Byte-string trie, where a node may end one of the inserted strings,
+	// remembered by its token (e.g. index in the source list).
+	class token_trie {
+	public:
+		static constexpr auto npos = static_cast<size_t>(-1);
+
+		template <typename Iterator>
+		void insert(Iterator first, Iterator last, size_t token) {
+			std::uint32_t current = 0;
+			for (; first != last; ++first) {
+				auto next = child(current, *first);
+				if (!next) {
+					next = static_cast<std::uint32_t>(nodes_.size());
+					nodes_[current].children.emplace_back(*first, next);
+					nodes_.emplace_back();
+				}
+				current = next;
+			}
+			// the first of duplicated alternatives is the one, which matches
+			if (nodes_[current].token == npos) nodes_[current].token = token;
+		}
+
+		// calls visit(length, token) for each token being a prefix of
+		// the range, shortest first; stops, if visit returns true
+		template <typename Iterator, typename Visitor>
+		void walk(Iterator first, Iterator last, Visitor&& visit) const {
+			std::uint32_t current = 0;
+			size_t length = 0;
+			while (true) {
+				auto const& node = nodes_[current];
+				if (node.token != npos && visit(length, node.token)) return;
+				if (first == last) return;
+				current = child(current, *first);
+				if (!current) return;
+				++first;
+				++length;
+			}
+		}
+
+	private:
+		struct node {
+			std::vector<std::pair<char, std::uint32_t>> children{};
+			size_t token{npos};
+		};
+
+		std::uint32_t child(std::uint32_t parent, char c) const {
+			// root is never a child, so zero means "not found"
+			for (auto const& [key, index] : nodes_[parent].children) {
+				if (key == c) return index;
+			}
+			return 0;
+		}
+
+		std::vector<node> nodes_ = std::vector<node>(1);
+	};
+}  // namespace distro
@@ -0,0 +1,73 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+#include <distro/semver.hh>
+
+namespace distro {
+	// Interval of versions, with an option to skip the prereleases. Since
+	// versions are totally ordered, any conjunction of comparisons is
+	// a single interval, which versions can look up with two binary
+	// searches. Read from space-separated terms:
+	//
+	//  - "1.2.3" is the exact version, or, if missing, the newest of its
+	//    prereleases (same as the requested version of get_archives),
+	//  - "1.2" and "1" are any version starting with the given parts,
+	//  - "^1.2.3" allows changes not modifying the first non-zero part,
+	//    "~1.2.3" only the patch ("~1" any minor),
+	//  - ">1.2.3", ">=1.2", "<2", "<=1.2.3" are plain comparisons, with
+	//    missing parts filled the same way as above (">1.2" is ">=1.3"),
+	//  - "stable" skips all prereleases, "*" allows anything.
+	//
+	// Bounds created from partial versions lie below the prereleases of
+	// the bound: "^15.2" picks 15.2.0-alpha, but not 16.0.0-alpha.
+	class version_constraint {
+	public:
+		struct bound {
+			semver version;
+			bool inclusive;
+			// The bound lies below every prerelease of the version. Since
+			// a longer prerelease sorts lower, there is no such semver, so
+			// only the numbers of the versions are compared with it.
+			bool before_prereleases{false};
+
+			// negative, zero or positive, as the version lies below, at
+			// or above the bound
+			int compare(semver const& ver) const;
+		};
+
+		version_constraint() = default;
+
+		// the bounds are copied with given allocator
+		static version_constraint exact(
+		    semver const& version,
+		    semver::allocator_type const& alloc = {});
+		static version_constraint newest_stable();
+		static std::optional<version_constraint> from_string(
+		    std::string_view view);
+
+		bool contains(semver const& version) const;
+		// the version is lower than any in the interval
+		bool below(semver const& version) const;
+		// the version is greater than any in the interval
+		bool above(semver const& version) const;
+
+		std::optional<bound> const& lower() const noexcept { return lower_; }
+		std::optional<bound> const& upper() const noexcept { return upper_; }
+		bool stable_only() const noexcept { return stable_only_; }
+
+	private:
+		void narrow_lower(bound&& next);
+		void narrow_upper(bound&& next);
+		bool add_term(std::string_view term);
+
+		std::optional<bound> lower_{};
+		std::optional<bound> upper_{};
+		bool stable_only_{false};
+	};
+}  // namespace distro
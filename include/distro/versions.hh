@@ -4,51 +4,405 @@
 
 #pragma once
 
-#include <map>
+#include <cstdint>
+#include <iosfwd>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <distro/errors.hh>
+#include <distro/observer.hh>
 #include <distro/package.hh>
+#include <distro/package_matcher.hh>
+#include <distro/package_sink.hh>
+#include <distro/package_source.hh>
+#include <distro/regex.hh>
+#include <distro/report.hh>
+#include <distro/symbols.hh>
+#include <distro/version_constraint.hh>
 
 namespace distro {
-	using StringSet = std::unordered_set<std::string>;
-
 	class versions {
 	public:
-		using Map = std::map<semver, std::vector<package>>;
-		using iterator = Map::iterator;
+		// Packages, their versions and the index are all allocated from
+		// one memory resource, given to the reading function. A scan into
+		// a std::pmr::monotonic_buffer_resource is released at once, with
+		// the resource; the set must not outlive it.
+		using allocator_type = std::pmr::polymorphic_allocator<>;
+
+		// one entry per version, in ascending order, each viewing its run
+		// of packages inside the contiguous, sorted package storage
+		using Index = std::pmr::vector<std::pair<semver, std::span<package>>>;
+		using iterator = Index::const_iterator;
+
+		versions() = default;
+		explicit versions(allocator_type const& alloc);
+		versions(versions const&);
+		versions(versions&&) = default;
+		versions(versions const& other, allocator_type const& alloc);
+		versions(versions&& other, allocator_type const& alloc);
+		versions& operator=(versions const&);
+		versions& operator=(versions&&);
+
+		allocator_type get_allocator() const noexcept {
+			return packages.get_allocator();
+		}
 
+		// Result of one query: the components wanted for the selected
+		// version and, once get_archives was called, the packages chosen to
+		// provide them. The versions object is only read, so any number of
+		// threads may hold their own comp_list over the same set. The
+		// lists are allocated from the resource given to components, not
+		// the one of the set.
 		class comp_list {
 		public:
-			std::vector<fs::path> get_archives();
-			void debug_print(std::ostream&);
+			using allocator_type = versions::allocator_type;
+
+			// Chooses the packages without building their paths; the
+			// packages() list them afterwards.
+			void select(observer* obs = nullptr);
+			// select() and the paths of the chosen packages
+			std::vector<fs::path> get_archives(observer* obs = nullptr);
+
+			// Lists the versions with what the last select or get_archives
+			// chose from them, see report_format. The first one appends to
+			// the string, the second formats everything into one buffer
+			// and writes it to the stream at once.
+			void report(report_format format, std::string& out) const;
+			void report(report_format format, std::ostream& out) const;
+			void debug_print(std::ostream& out) const {
+				report(report_format::ansi, out);
+			}
+
+			// packages chosen by the last select or get_archives, in the
+			// order of the archives
+			std::span<package const* const> packages() const noexcept {
+				return chosen_;
+			}
+			bool selected(package const& pkg) const noexcept;
 
 		private:
 			friend class versions;
-			comp_list(versions* parent, iterator selected, StringSet&& list)
+			comp_list(versions const* parent,
+			          iterator selected,
+			          symbol_set&& list,
+			          arch_filter&& architectures,
+			          allocator_type const& alloc)
 			    : parent_{parent}
 			    , selected_{selected}
-			    , list_{std::move(list)} {}
-			versions* parent_;
+			    , list_{std::move(list)}
+			    , architectures_{std::move(architectures)}
+			    , missing_{alloc}
+			    , chosen_{alloc} {}
+
+			void choose();
+			template <typename Renderer>
+			void render(Renderer& renderer) const;
+
+			versions const* parent_;
 			iterator selected_;
-			StringSet list_;
+			symbol_set list_;
+			arch_filter architectures_;
+			// components nobody provided, after select
+			symbol_set missing_;
+			std::pmr::vector<package const*> chosen_;
+		};
+
+		// Archives each version would get from comp_list::get_archives, if
+		// it was the selected one, for all versions at once. Rows view the
+		// packages of the versions object, which must outlive the table.
+		class resolution_table {
+		public:
+			struct row {
+				semver const& version;
+				// packages of the version itself first, then providers of
+				// the remaining components, newest first
+				std::span<package const* const> packages;
+				versions const& parent;
+
+				std::vector<fs::path> archives() const;
+			};
+
+			size_t size() const noexcept { return rows_.size(); }
+			bool empty() const noexcept { return rows_.empty(); }
+			row operator[](size_t index) const noexcept;
+
+		private:
+			friend class versions;
+			struct entry {
+				semver const* version;
+				size_t first;
+				size_t last;
+			};
+			versions const* parent_{};
+			std::vector<entry> rows_{};
+			std::vector<package const*> packages_{};
+		};
+
+		// result for one of the architecture sets; version is empty, if no
+		// package matched that set
+		struct platform_archives {
+			std::optional<semver> version{};
+			std::vector<fs::path> archives{};
 		};
 
+		// Every step below, which takes an observer, reports its counters
+		// and timings into it, if one is given.
+		static std::vector<fs::path> get_archives(
+		    fs::path const& srcdir,
+		    StringSet const& architectures,
+		    std::optional<semver>& requested,
+		    regex_matcher const& file_matcher,
+		    bool debug,
+		    std::ostream& debug_out,
+		    errors& log,
+		    observer* obs = nullptr);
 		static std::vector<fs::path> get_archives(
 		    fs::path const& srcdir,
 		    StringSet const& architectures,
 		    std::optional<semver>& requested,
-		    std::regex const& file_matcher,
+		    file_matcher const& matcher,
 		    bool debug,
 		    std::ostream& debug_out,
+		    errors& log,
+		    observer* obs = nullptr);
+		// Scans srcdir once, for all architecture sets together, and
+		// resolves the archives for each of the sets, in the same order.
+		static std::vector<platform_archives> get_platform_archives(
+		    fs::path const& srcdir,
+		    std::vector<StringSet> const& architectures,
+		    std::optional<semver> const& requested,
+		    regex_matcher const& file_matcher,
+		    errors& log);
+		static std::vector<platform_archives> get_platform_archives(
+		    fs::path const& srcdir,
+		    std::vector<StringSet> const& architectures,
+		    std::optional<semver> const& requested,
+		    file_matcher const& matcher,
 		    errors& log);
+		// Same as read_packages, but takes the names from given source,
+		// for example a manifest_source, which needs no directory access.
+		// Each of them allocates the set from `alloc`.
+		static versions read_packages(package_source const& source,
+		                              StringSet const& architectures,
+		                              regex_matcher const& matcher,
+		                              errors const& log,
+		                              observer* obs = nullptr,
+		                              allocator_type const& alloc = {});
+		static versions read_packages(package_source const& source,
+		                              StringSet const& architectures,
+		                              file_matcher const& matcher,
+		                              errors const& log,
+		                              observer* obs = nullptr,
+		                              allocator_type const& alloc = {});
+		static versions read_packages(fs::path const& srcdir,
+		                              StringSet const& architectures,
+		                              regex_matcher const& matcher,
+		                              errors const& log,
+		                              observer* obs = nullptr,
+		                              allocator_type const& alloc = {});
 		static versions read_packages(fs::path const& srcdir,
 		                              StringSet const& architectures,
-		                              std::regex const& matcher,
-		                              errors const& log);
+		                              file_matcher const& matcher,
+		                              errors const& log,
+		                              observer* obs = nullptr,
+		                              allocator_type const& alloc = {});
+		// Same as read_packages, but keeps only what resolving `requested`
+		// (or the newest version, if empty) can use: the packages of the
+		// version find_selected would pick and the newest provider of each
+		// component below it. Versions above the requested one are dropped
+		// as soon as they are parsed and superseded providers are released
+		// during the scan, so the memory depends on the number of
+		// components, not on the size of the directory. Requested version,
+		// which cannot be selected, is reported right after the scan.
+		static versions read_selected(fs::path const& srcdir,
+		                              StringSet const& architectures,
+		                              std::optional<semver> const& requested,
+		                              regex_matcher const& matcher,
+		                              errors const& log,
+		                              observer* obs = nullptr,
+		                              allocator_type const& alloc = {});
+		static versions read_selected(fs::path const& srcdir,
+		                              StringSet const& architectures,
+		                              std::optional<semver> const& requested,
+		                              file_matcher const& matcher,
+		                              errors const& log,
+		                              observer* obs = nullptr,
+		                              allocator_type const& alloc = {});
+		// Same as read_selected, but shows each package to the sink as
+		// soon as it is matched and settles the archives of the query in
+		// the sink as soon as they are certain, so that the caller may
+		// start working on them before the scan is over. With an explicit
+		// `requested` version, its own packages are settled right as they
+		// are found; the components taken from older versions, and
+		// anything of the newest version, are settled once the scan ends,
+		// when nothing newer may turn up. After the call, the sink got
+		// the same archives get_archives would return.
+		static versions stream_selected(package_source const& source,
+		                                StringSet const& architectures,
+		                                std::optional<semver> const& requested,
+		                                regex_matcher const& matcher,
+		                                package_sink& sink,
+		                                errors const& log,
+		                                observer* obs = nullptr,
+		                                allocator_type const& alloc = {});
+		static versions stream_selected(package_source const& source,
+		                                StringSet const& architectures,
+		                                std::optional<semver> const& requested,
+		                                file_matcher const& matcher,
+		                                package_sink& sink,
+		                                errors const& log,
+		                                observer* obs = nullptr,
+		                                allocator_type const& alloc = {});
+		static versions stream_selected(fs::path const& srcdir,
+		                                StringSet const& architectures,
+		                                std::optional<semver> const& requested,
+		                                regex_matcher const& matcher,
+		                                package_sink& sink,
+		                                errors const& log,
+		                                observer* obs = nullptr,
+		                                allocator_type const& alloc = {});
+		static versions stream_selected(fs::path const& srcdir,
+		                                StringSet const& architectures,
+		                                std::optional<semver> const& requested,
+		                                file_matcher const& matcher,
+		                                package_sink& sink,
+		                                errors const& log,
+		                                observer* obs = nullptr,
+		                                allocator_type const& alloc = {});
+		// Scans several roots (shards, mirrors) concurrently, on at most
+		// `threads` workers (zero for one per hardware thread) and merges
+		// them into one set. If the same archive name is found in more than
+		// one root, the package from the root listed first is kept.
+		static versions read_roots(std::vector<fs::path> const& srcdirs,
+		                           StringSet const& architectures,
+		                           regex_matcher const& matcher,
+		                           errors const& log,
+		                           unsigned threads = 0);
+		static versions read_roots(std::vector<fs::path> const& srcdirs,
+		                           StringSet const& architectures,
+		                           file_matcher const& matcher,
+		                           errors const& log,
+		                           unsigned threads = 0);
+		// Same as read_packages, for a srcdir, in which the archives are
+		// sorted into version directories, named after the leading numbers
+		// of the versions inside and nested as deep as needed, for example
+		// 15/15.2/my-app-15.2.10-beta-anywhere-doc.zip. Archives of versions
+		// not starting with the name of their directory are skipped, and
+		// so are directories not extending the name of their parent. The
+		// directories are read on at most `threads` workers (zero for one
+		// per hardware thread); the result does not depend on their number.
+		static versions read_tree(fs::path const& srcdir,
+		                          StringSet const& architectures,
+		                          regex_matcher const& matcher,
+		                          errors const& log,
+		                          unsigned threads = 0,
+		                          observer* obs = nullptr);
+		static versions read_tree(fs::path const& srcdir,
+		                          StringSet const& architectures,
+		                          file_matcher const& matcher,
+		                          errors const& log,
+		                          unsigned threads = 0,
+		                          observer* obs = nullptr);
+		// Same as read_selected, for a tree read_tree understands. Newest
+		// directories are read first and the ones above `requested` are
+		// not read at all. If the components of the distribution are
+		// listed, the directories below both the selected version and the
+		// newest provider of each of the components are not read either,
+		// as soon as the directories read before found all of them. With
+		// an empty list, older directories are read for whatever they may
+		// provide.
+		static versions read_tree_selected(
+		    fs::path const& srcdir,
+		    StringSet const& architectures,
+		    std::optional<semver> const& requested,
+		    StringSet const& components,
+		    regex_matcher const& matcher,
+		    errors const& log,
+		    unsigned threads = 0,
+		    observer* obs = nullptr);
+		static versions read_tree_selected(
+		    fs::path const& srcdir,
+		    StringSet const& architectures,
+		    std::optional<semver> const& requested,
+		    StringSet const& components,
+		    file_matcher const& matcher,
+		    errors const& log,
+		    unsigned threads = 0,
+		    observer* obs = nullptr);
+		// Same as read_packages, but keeps the matched packages, already
+		// parsed, in an index file, reused for as long as srcdir stays the
+		// same directory with the same modification time and the matcher
+		// is built from the same arguments. Loading it neither lists the
+		// directory, nor matches the names, nor parses the versions; the
+		// packages are still copied out of it and sorted. The file is
+		// replaced atomically and read through a read-only mapping, so
+		// processes may share it.
+		static versions read_cached(fs::path const& srcdir,
+		                            fs::path const& index_file,
+		                            StringSet const& architectures,
+		                            file_matcher const& matcher,
+		                            errors const& log);
+		// Scans once for all the packages of the matcher and returns one
+		// set per package name, in the order of the matcher. Any of them
+		// may be resolved later without another scan.
+		static std::vector<versions> read_many(
+		    fs::path const& srcdir,
+		    StringSet const& architectures,
+		    package_matcher const& matcher,
+		    errors const& log,
+		    observer* obs = nullptr);
+		static std::vector<versions> read_many(
+		    package_source const& source,
+		    StringSet const& architectures,
+		    package_matcher const& matcher,
+		    errors const& log,
+		    observer* obs = nullptr);
+		iterator find_selected(std::optional<semver>& requested,
+		                       errors const& log,
+		                       observer* obs = nullptr) const;
+		comp_list components(iterator const& selected,
+		                     observer* obs = nullptr,
+		                     allocator_type const& alloc = {}) const;
+
+		// Variants limited to packages built for given architectures (all,
+		// if the set is empty), for sets read with a wider filter. Versions
+		// without any such package are skipped, as if they were not there.
 		iterator find_selected(std::optional<semver>& requested,
-		                       errors const& log);
-		comp_list components(iterator const& selected);
+		                       errors const& log,
+		                       StringSet const& architectures,
+		                       observer* obs = nullptr) const;
+		comp_list components(iterator const& selected,
+		                     StringSet const& architectures,
+		                     observer* obs = nullptr,
+		                     allocator_type const& alloc = {}) const;
+		bool provides(StringSet const& architectures) const noexcept;
+
+		// Newest version satisfying the constraint, with at least one
+		// package for the architectures, or end(). The bounds are found
+		// with binary searches; only the versions inside them, which are
+		// skipped for being prereleases or for other architectures, are
+		// walked over. find_selected is this query for exact(requested).
+		iterator find_newest(version_constraint const& query) const;
+		iterator find_newest(version_constraint const& query,
+		                     StringSet const& architectures) const;
+
+		// Resolves every version in one forward sweep, carrying the newest
+		// provider of each component along, instead of calling
+		// find_selected and components once per version.
+		resolution_table resolve_all() const;
+		resolution_table resolve_all(StringSet const& architectures) const;
+
+		// full path of one of the packages of this set
+		fs::path archive(package const& pkg) const;
+
+		// names of the architectures and components of the packages
+		symbol_table const& symbols() const noexcept { return table; }
+		std::string_view name(symbol id) const noexcept {
+			return table.name(id);
+		}
 
 		auto begin() const noexcept { return items.begin(); }
 		auto end() const noexcept { return items.end(); }
@@ -56,6 +410,109 @@ namespace distro {
 		auto empty() const noexcept { return items.empty(); }
 
 	private:
-		Map items;
+		// publishes its own, already sorted, packages
+		friend class repository;
+
+		template <typename Matcher>
+		static std::vector<fs::path> get_archives_impl(
+		    fs::path const& srcdir,
+		    StringSet const& architectures,
+		    std::optional<semver>& requested,
+		    Matcher const& matcher,
+		    bool debug,
+		    std::ostream& debug_out,
+		    errors& log,
+		    observer* obs);
+		template <typename Matcher>
+		static std::vector<platform_archives> get_platform_archives_impl(
+		    fs::path const& srcdir,
+		    std::vector<StringSet> const& architectures,
+		    std::optional<semver> const& requested,
+		    Matcher const& matcher,
+		    errors& log);
+		template <typename Matcher>
+		static versions read_packages_impl(package_source const& source,
+		                                   StringSet const& architectures,
+		                                   Matcher const& matcher,
+		                                   errors const& log,
+		                                   observer* obs,
+		                                   allocator_type const& alloc);
+		template <typename Matcher>
+		static versions read_selected_impl(
+		    package_source const& source,
+		    StringSet const& architectures,
+		    std::optional<semver> const& requested,
+		    Matcher const& matcher,
+		    errors const& log,
+		    observer* obs,
+		    allocator_type const& alloc);
+		template <typename Matcher>
+		static versions stream_selected_impl(
+		    package_source const& source,
+		    StringSet const& architectures,
+		    std::optional<semver> const& requested,
+		    Matcher const& matcher,
+		    package_sink& sink,
+		    errors const& log,
+		    observer* obs,
+		    allocator_type const& alloc);
+		template <typename Matcher>
+		static versions read_roots_impl(std::vector<fs::path> const& srcdirs,
+		                                StringSet const& architectures,
+		                                Matcher const& matcher,
+		                                errors const& log,
+		                                unsigned threads);
+		template <typename Matcher>
+		static versions read_tree_impl(fs::path const& srcdir,
+		                               StringSet const& architectures,
+		                               Matcher const& matcher,
+		                               errors const& log,
+		                               unsigned threads,
+		                               observer* obs);
+		template <typename Matcher>
+		static versions read_tree_selected_impl(
+		    fs::path const& srcdir,
+		    StringSet const& architectures,
+		    std::optional<semver> const& requested,
+		    StringSet const& components,
+		    Matcher const& matcher,
+		    errors const& log,
+		    unsigned threads,
+		    observer* obs);
+		iterator find_newest(version_constraint const& query,
+		                     arch_filter const& architectures) const;
+		// the set takes the allocator of the packages
+		static versions from_packages(std::vector<fs::path>&& roots,
+		                              symbol_table&& table,
+		                              std::pmr::vector<package>&& packages,
+		                              observer* obs = nullptr);
+
+		// one package providing a component: positions in items and in
+		// packages
+		struct component_provider {
+			size_t version;
+			size_t package;
+		};
+
+		// newest package providing the component in versions below given
+		// position in items, first one inside its version, the same one a
+		// reverse walk over the older versions would find
+		std::optional<component_provider> newest_provider(
+		    symbol comp,
+		    size_t below,
+		    arch_filter const& architectures) const;
+
+		void build_index();
+
+		std::vector<fs::path> roots;
+		symbol_table table;
+		std::pmr::vector<package> packages;
+		Index items;
+		// packages of each component, indexed by its symbol, in the order
+		// of the storage, so sorted by version
+		std::pmr::vector<std::pmr::vector<component_provider>> providers;
+		// positions in packages, each version's run in the order of the
+		// reports: main package first, then by component name and version
+		std::pmr::vector<std::uint32_t> listing;
 	};
 }  // namespace distro
\ No newline at end of file
@@ -0,0 +1,126 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "archive.hh"
+
+namespace distro {
+	namespace archive {
+		using namespace std::literals;
+
+		namespace {
+			bool starts_with(std::string_view bytes, std::string_view magic) {
+				return bytes.substr(0, magic.size()) == magic;
+			}
+
+			// splits on both separators, as zip files made on Windows use
+			// backslashes; calls visit(component) for each non-empty one
+			template <typename Visitor>
+			void for_each_component(std::string_view path, Visitor&& visit) {
+				while (!path.empty()) {
+					auto const sep = path.find_first_of("/\\");
+					auto const comp = path.substr(0, sep);
+					if (!comp.empty()) visit(comp);
+					if (sep == std::string_view::npos) break;
+					path = path.substr(sep + 1);
+				}
+			}
+
+			bool is_absolute(std::string_view path) {
+				if (!path.empty() &&
+				    (path.front() == '/' || path.front() == '\\'))
+					return true;
+				// drive letter
+				return path.size() > 1 && path[1] == ':';
+			}
+		}  // namespace
+
+		entry_sink::~entry_sink() = default;
+
+		std::string safe_path(std::string_view path, std::error_code& ec) {
+			if (is_absolute(path)) {
+				ec = make_error_code(extract_errc::unsafe_path);
+				return {};
+			}
+
+			std::string result{};
+			result.reserve(path.size());
+			for_each_component(path, [&](std::string_view comp) {
+				if (comp == "."sv) return;
+				if (comp == ".."sv) {
+					ec = make_error_code(extract_errc::unsafe_path);
+					return;
+				}
+				if (!result.empty()) result.push_back('/');
+				result.append(comp);
+			});
+
+			if (ec) return {};
+			return result;
+		}
+
+		std::optional<std::vector<std::string>> link_route(
+		    std::string_view path,
+		    std::string_view target) {
+			if (is_absolute(target)) return std::nullopt;
+
+			// the directory of the link
+			std::vector<std::string_view> stack{};
+			for_each_component(
+			    path, [&](std::string_view comp) { stack.push_back(comp); });
+			if (!stack.empty()) stack.pop_back();
+
+			auto const current = [&] {
+				std::string result{};
+				for (auto comp : stack) {
+					if (!result.empty()) result.push_back('/');
+					result.append(comp);
+				}
+				return result;
+			};
+
+			std::vector<std::string> route{};
+			bool escaped = false;
+			for_each_component(target, [&](std::string_view comp) {
+				if (escaped || comp == "."sv) return;
+				// anything after a name means going into it
+				if (!stack.empty()) route.push_back(current());
+				if (comp != ".."sv) {
+					stack.push_back(comp);
+					return;
+				}
+				if (stack.empty())
+					escaped = true;
+				else
+					stack.pop_back();
+			});
+			if (escaped) return std::nullopt;
+			return route;
+		}
+
+		bool safe_link(std::string_view path, std::string_view target) {
+			return link_route(path, target).has_value();
+		}
+
+		std::error_code unpack(std::string_view bytes, entry_sink& sink) {
+			if (starts_with(bytes, "PK\x03\x04"sv) ||
+			    starts_with(bytes, "PK\x05\x06"sv))
+				return read_zip(bytes, sink);
+
+			std::error_code ec{};
+			std::unique_ptr<byte_source> source{};
+			if (starts_with(bytes, "\x1f\x8b"sv))
+				source = gzip_stream(bytes, ec);
+			else if (starts_with(bytes, "BZh"sv))
+				source = bzip2_stream(bytes, ec);
+			else if (starts_with(bytes, "\xFD" "7zXZ\0"sv))
+				source = xz_stream(bytes, ec);
+			else
+				source = memory_stream(bytes);
+			if (ec) return ec;
+
+			// read_tar tells a tar by its checksum
+			return read_tar(*source, sink);
+		}
+	}  // namespace archive
+}  // namespace distro
@@ -0,0 +1,94 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <distro/extract.hh>
+
+namespace distro {
+	namespace archive {
+		// Receives the entries of an archive, in the order they are stored.
+		// Paths are relative, with '/' separators and without any "." or
+		// ".." components. Contents of a file come in chunks between
+		// file_begin and file_end.
+		class entry_sink {
+		public:
+			virtual ~entry_sink();
+			virtual std::error_code directory(std::string_view path) = 0;
+			virtual std::error_code symlink(std::string_view path,
+			                                std::string_view target) = 0;
+			// target is a path of an earlier entry of the same archive
+			virtual std::error_code hardlink(std::string_view path,
+			                                 std::string_view target) = 0;
+			virtual std::error_code file_begin(std::string_view path,
+			                                   std::uint32_t mode) = 0;
+			virtual std::error_code file_data(std::string_view chunk) = 0;
+			virtual std::error_code file_end() = 0;
+		};
+
+		// stream of decompressed bytes
+		class byte_source {
+		public:
+			virtual ~byte_source();
+			// fills the buffer as much as it can, shorter only at the end of
+			// the data
+			virtual std::error_code read(std::span<char> buffer,
+			                             size_t& count) = 0;
+		};
+
+		// gzip, bzip2 and xz streams over the compressed bytes; nullptr with
+		// unsupported_format, if this build lacks the library
+		std::unique_ptr<byte_source> memory_stream(std::string_view bytes);
+		std::unique_ptr<byte_source> gzip_stream(std::string_view bytes,
+		                                         std::error_code& ec);
+		std::unique_ptr<byte_source> bzip2_stream(std::string_view bytes,
+		                                          std::error_code& ec);
+		std::unique_ptr<byte_source> xz_stream(std::string_view bytes,
+		                                       std::error_code& ec);
+
+		// raw deflate of a zip entry, checked against its CRC-32
+		std::error_code inflate(std::string_view compressed,
+		                        std::uint64_t size,
+		                        std::uint32_t crc,
+		                        entry_sink& sink);
+		// CRC-32 of a stored zip entry; false, if this build cannot
+		// compute it
+		bool crc32(std::string_view data, std::uint32_t& crc);
+
+		std::error_code read_tar(byte_source& source, entry_sink& sink);
+		std::error_code read_zip(std::string_view bytes, entry_sink& sink);
+
+		// recognizes the format from the first bytes and hands the entries
+		// over to the sink
+		std::error_code unpack(std::string_view bytes, entry_sink& sink);
+
+		// archive path made relative and safe, or empty for the root itself;
+		// sets unsafe_path for absolute paths and for ".." components
+		std::string safe_path(std::string_view path, std::error_code& ec);
+
+		// Directories the link target, relative to the directory of the
+		// link, goes through on its way, as paths relative to the
+		// destination, in order. The directory of the link comes first,
+		// the end of the target is not listed. Nullopt for absolute
+		// targets and for targets leaving the destination. Resolved on
+		// paper only, any of the directories may be a link, too.
+		std::optional<std::vector<std::string>> link_route(
+		    std::string_view path,
+		    std::string_view target);
+
+		// is the link target, relative to the directory of the link, staying
+		// inside of the destination, as long as no other link is on the
+		// way?
+		bool safe_link(std::string_view path, std::string_view target);
+	}  // namespace archive
+}  // namespace distro
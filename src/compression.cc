@@ -0,0 +1,344 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "archive.hh"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+
+#ifdef DISTRO_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DISTRO_HAS_BZIP2
+#include <bzlib.h>
+#endif
+#ifdef DISTRO_HAS_LZMA
+#include <lzma.h>
+#endif
+
+namespace distro {
+	namespace archive {
+		namespace {
+			[[maybe_unused]] std::error_code damaged() {
+				return make_error_code(extract_errc::damaged_archive);
+			}
+
+			// zlib and bzip2 count the input in unsigned ints
+			[[maybe_unused]] unsigned input_chunk(size_t left) {
+				return static_cast<unsigned>(
+				    std::min(left, size_t{UINT_MAX}));
+			}
+
+			class memory_source : public byte_source {
+			public:
+				explicit memory_source(std::string_view bytes)
+				    : bytes_{bytes} {}
+
+				std::error_code read(std::span<char> buffer,
+				                     size_t& count) override {
+					count = std::min(buffer.size(), bytes_.size());
+					std::copy_n(bytes_.data(), count, buffer.data());
+					bytes_.remove_prefix(count);
+					return {};
+				}
+
+			private:
+				std::string_view bytes_;
+			};
+
+#ifdef DISTRO_HAS_ZLIB
+			// z_stream keeps pointers to itself, so it must not move
+			class zlib_stream {
+			public:
+				explicit zlib_stream(int window_bits) {
+					ok_ = inflateInit2(&stream_, window_bits) == Z_OK;
+				}
+				~zlib_stream() {
+					if (ok_) inflateEnd(&stream_);
+				}
+				zlib_stream(zlib_stream const&) = delete;
+				zlib_stream& operator=(zlib_stream const&) = delete;
+
+				explicit operator bool() const noexcept { return ok_; }
+				z_stream* operator->() noexcept { return &stream_; }
+				z_stream* get() noexcept { return &stream_; }
+
+			private:
+				z_stream stream_{};
+				bool ok_{false};
+			};
+
+			class gzip_source : public byte_source {
+			public:
+				explicit gzip_source(std::string_view bytes)
+				    : stream_{MAX_WBITS + 16}, left_{bytes} {}
+
+				explicit operator bool() const noexcept {
+					return !!stream_;
+				}
+
+				std::error_code read(std::span<char> buffer,
+				                     size_t& count) override {
+					count = 0;
+					while (count < buffer.size() && !done_) {
+						if (!stream_->avail_in) {
+							stream_->next_in = reinterpret_cast<Bytef*>(
+							    const_cast<char*>(left_.data()));
+							stream_->avail_in = input_chunk(left_.size());
+							left_.remove_prefix(stream_->avail_in);
+						}
+
+						auto const room = input_chunk(buffer.size() - count);
+						stream_->next_out =
+						    reinterpret_cast<Bytef*>(buffer.data() + count);
+						stream_->avail_out = room;
+						auto const ret = ::inflate(stream_.get(), Z_NO_FLUSH);
+						count += room - stream_->avail_out;
+
+						if (ret == Z_STREAM_END) {
+							// gzip files may be a concatenation of members
+							if (!stream_->avail_in && left_.empty())
+								done_ = true;
+							else if (inflateReset(stream_.get()) != Z_OK)
+								return damaged();
+							continue;
+						}
+						if (ret == Z_BUF_ERROR && !stream_->avail_in &&
+						    left_.empty())
+							return damaged();
+						if (ret != Z_OK && ret != Z_BUF_ERROR)
+							return damaged();
+					}
+					return {};
+				}
+
+			private:
+				zlib_stream stream_;
+				std::string_view left_;
+				bool done_{false};
+			};
+#endif
+
+#ifdef DISTRO_HAS_BZIP2
+			class bzip2_source : public byte_source {
+			public:
+				explicit bzip2_source(std::string_view bytes) : left_{bytes} {
+					ok_ = BZ2_bzDecompressInit(&stream_, 0, 0) == BZ_OK;
+				}
+				~bzip2_source() {
+					if (ok_) BZ2_bzDecompressEnd(&stream_);
+				}
+				bzip2_source(bzip2_source const&) = delete;
+				bzip2_source& operator=(bzip2_source const&) = delete;
+
+				explicit operator bool() const noexcept { return ok_; }
+
+				std::error_code read(std::span<char> buffer,
+				                     size_t& count) override {
+					count = 0;
+					while (count < buffer.size() && !done_) {
+						if (!stream_.avail_in) {
+							stream_.next_in = const_cast<char*>(left_.data());
+							stream_.avail_in = input_chunk(left_.size());
+							left_.remove_prefix(stream_.avail_in);
+						}
+
+						auto const room = input_chunk(buffer.size() - count);
+						stream_.next_out = buffer.data() + count;
+						stream_.avail_out = room;
+						auto const ret = BZ2_bzDecompress(&stream_);
+						count += room - stream_.avail_out;
+
+						if (ret == BZ_STREAM_END) {
+							// so may bzip2 files, as made by pbzip2
+							if (!stream_.avail_in && left_.empty()) {
+								done_ = true;
+								continue;
+							}
+							auto const next_in = stream_.next_in;
+							auto const avail_in = stream_.avail_in;
+							BZ2_bzDecompressEnd(&stream_);
+							stream_ = {};
+							ok_ = BZ2_bzDecompressInit(&stream_, 0, 0) == BZ_OK;
+							if (!ok_) return damaged();
+							stream_.next_in = next_in;
+							stream_.avail_in = avail_in;
+							continue;
+						}
+						if (ret != BZ_OK) return damaged();
+						if (!stream_.avail_in && left_.empty() &&
+						    stream_.avail_out)
+							return damaged();
+					}
+					return {};
+				}
+
+			private:
+				bz_stream stream_{};
+				std::string_view left_;
+				bool ok_{false};
+				bool done_{false};
+			};
+#endif
+
+#ifdef DISTRO_HAS_LZMA
+			class xz_source : public byte_source {
+			public:
+				explicit xz_source(std::string_view bytes) {
+					ok_ = lzma_stream_decoder(&stream_, UINT64_MAX,
+					                          LZMA_CONCATENATED) == LZMA_OK;
+					stream_.next_in =
+					    reinterpret_cast<std::uint8_t const*>(bytes.data());
+					stream_.avail_in = bytes.size();
+				}
+				~xz_source() { lzma_end(&stream_); }
+				xz_source(xz_source const&) = delete;
+				xz_source& operator=(xz_source const&) = delete;
+
+				explicit operator bool() const noexcept { return ok_; }
+
+				std::error_code read(std::span<char> buffer,
+				                     size_t& count) override {
+					count = 0;
+					while (count < buffer.size() && !done_) {
+						auto const room = buffer.size() - count;
+						stream_.next_out =
+						    reinterpret_cast<std::uint8_t*>(buffer.data()) +
+						    count;
+						stream_.avail_out = room;
+						// all of the input is there from the start
+						auto const ret = lzma_code(&stream_, LZMA_FINISH);
+						count += room - stream_.avail_out;
+
+						if (ret == LZMA_STREAM_END)
+							done_ = true;
+						else if (ret != LZMA_OK)
+							return damaged();
+					}
+					return {};
+				}
+
+			private:
+				lzma_stream stream_ = LZMA_STREAM_INIT;
+				bool ok_{false};
+				bool done_{false};
+			};
+#endif
+
+			template <typename Source>
+			std::unique_ptr<byte_source> stream_of(std::string_view bytes,
+			                                       std::error_code& ec) {
+				auto result = std::make_unique<Source>(bytes);
+				if (!*result) {
+					ec = std::make_error_code(std::errc::not_enough_memory);
+					return {};
+				}
+				return result;
+			}
+
+			[[maybe_unused]] std::unique_ptr<byte_source> unsupported(
+			    std::error_code& ec) {
+				ec = make_error_code(extract_errc::unsupported_format);
+				return {};
+			}
+		}  // namespace
+
+		byte_source::~byte_source() = default;
+
+		std::unique_ptr<byte_source> memory_stream(std::string_view bytes) {
+			return std::make_unique<memory_source>(bytes);
+		}
+
+		std::unique_ptr<byte_source> gzip_stream(
+		    [[maybe_unused]] std::string_view bytes,
+		    std::error_code& ec) {
+#ifdef DISTRO_HAS_ZLIB
+			return stream_of<gzip_source>(bytes, ec);
+#else
+			return unsupported(ec);
+#endif
+		}
+
+		std::unique_ptr<byte_source> bzip2_stream(
+		    [[maybe_unused]] std::string_view bytes,
+		    std::error_code& ec) {
+#ifdef DISTRO_HAS_BZIP2
+			return stream_of<bzip2_source>(bytes, ec);
+#else
+			return unsupported(ec);
+#endif
+		}
+
+		std::unique_ptr<byte_source> xz_stream(
+		    [[maybe_unused]] std::string_view bytes,
+		    std::error_code& ec) {
+#ifdef DISTRO_HAS_LZMA
+			return stream_of<xz_source>(bytes, ec);
+#else
+			return unsupported(ec);
+#endif
+		}
+
+		std::error_code inflate([[maybe_unused]] std::string_view compressed,
+		                        [[maybe_unused]] std::uint64_t size,
+		                        [[maybe_unused]] std::uint32_t crc,
+		                        [[maybe_unused]] entry_sink& sink) {
+#ifdef DISTRO_HAS_ZLIB
+			zlib_stream stream{-MAX_WBITS};
+			if (!stream)
+				return std::make_error_code(std::errc::not_enough_memory);
+
+			std::array<char, 64 * 1024> buffer{};
+			std::uint64_t written{};
+			auto check = ::crc32(0, nullptr, 0);
+			auto ret = Z_OK;
+			while (ret != Z_STREAM_END) {
+				// with all of the input taken, a full buffer may still
+				// leave the end of the stream pending; if there is none,
+				// inflate reports Z_BUF_ERROR
+				if (!stream->avail_in && !compressed.empty()) {
+					stream->next_in = reinterpret_cast<Bytef*>(
+					    const_cast<char*>(compressed.data()));
+					stream->avail_in = input_chunk(compressed.size());
+					compressed.remove_prefix(stream->avail_in);
+				}
+
+				stream->next_out = reinterpret_cast<Bytef*>(buffer.data());
+				stream->avail_out = static_cast<uInt>(buffer.size());
+				ret = ::inflate(stream.get(), Z_NO_FLUSH);
+				if (ret != Z_OK && ret != Z_STREAM_END) return damaged();
+
+				auto const chunk = buffer.size() - stream->avail_out;
+				check = ::crc32(check, reinterpret_cast<Bytef*>(buffer.data()),
+				                static_cast<uInt>(chunk));
+				written += chunk;
+				if (auto ec = sink.file_data({buffer.data(), chunk})) return ec;
+			}
+
+			if (written != size || check != crc) return damaged();
+			return {};
+#else
+			return make_error_code(extract_errc::unsupported_entry);
+#endif
+		}
+
+		bool crc32([[maybe_unused]] std::string_view data,
+		           [[maybe_unused]] std::uint32_t& crc) {
+#ifdef DISTRO_HAS_ZLIB
+			auto check = ::crc32(0, nullptr, 0);
+			while (!data.empty()) {
+				auto const chunk = input_chunk(data.size());
+				check = ::crc32(
+				    check, reinterpret_cast<Bytef const*>(data.data()), chunk);
+				data.remove_prefix(chunk);
+			}
+			crc = static_cast<std::uint32_t>(check);
+			return true;
+#else
+			return false;
+#endif
+		}
+	}  // namespace archive
+}  // namespace distro
@@ -0,0 +1,107 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "dir_scan.hh"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+namespace distro {
+	namespace {
+		// enough for a couple of thousands of entries per syscall
+		constexpr size_t buffer_size = 256 * 1024;
+
+		// layout of struct linux_dirent64
+		constexpr size_t reclen_offset = 16;
+		constexpr size_t type_offset = 18;
+		constexpr size_t name_offset = 19;
+
+		// the values of DT_* from <dirent.h>
+		constexpr unsigned char dt_unknown = 0;
+		constexpr unsigned char dt_dir = 4;
+		constexpr unsigned char dt_lnk = 10;
+
+		std::error_code last_error() {
+			return {errno, std::system_category()};
+		}
+	}  // namespace
+
+	dirent_reader::dirent_reader(fs::path const& srcdir) {
+		fd_ = ::open(srcdir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd_ < 0) {
+			ec_ = last_error();
+			return;
+		}
+		buffer_.reset(new std::uint64_t[buffer_size / sizeof(std::uint64_t)]);
+	}
+
+	dirent_reader::~dirent_reader() {
+		if (fd_ >= 0) ::close(fd_);
+	}
+
+	bool dirent_reader::read(std::vector<std::string_view>& names,
+	                         std::vector<unsigned char>& types,
+	                         scan_stats& stats,
+	                         std::vector<std::string_view>* directories) {
+		names.clear();
+		types.clear();
+		if (directories) directories->clear();
+
+		while (names.empty() && (!directories || directories->empty())) {
+			if (fd_ < 0) return false;
+
+			auto const size = ::syscall(SYS_getdents64, fd_, buffer_.get(),
+			                            buffer_size);
+			if (size < 0) {
+				ec_ = last_error();
+				return false;
+			}
+			if (size == 0) return false;
+
+			auto const* bytes = reinterpret_cast<char const*>(buffer_.get());
+			auto const* end = bytes + size;
+			while (bytes < end) {
+				unsigned short reclen{};
+				std::memcpy(&reclen, bytes + reclen_offset, sizeof(reclen));
+				auto const type =
+				    static_cast<unsigned char>(bytes[type_offset]);
+				std::string_view const name{bytes + name_offset};
+				bytes += reclen;
+
+				if (name == "." || name == "..") continue;
+				++stats.entries;
+				if (type == dt_dir) {
+					if (directories) directories->push_back(name);
+					continue;
+				}
+
+				names.push_back(name);
+				types.push_back(type);
+			}
+		}
+
+		return true;
+	}
+
+	bool dirent_reader::is_directory(std::string_view name,
+	                                 unsigned char type,
+	                                 scan_stats& stats) const {
+		if (type != dt_unknown && type != dt_lnk) return false;
+
+		++stats.directory_checks;
+		struct stat st {};
+		// same as is_directory(ec): skip on error; the name is followed by
+		// the terminating zero inside the buffer
+		if (::fstatat(fd_, name.data(), &st, 0)) return true;
+		return S_ISDIR(st.st_mode);
+	}
+}  // namespace distro
+#endif
@@ -0,0 +1,183 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <distro/name_prefilter.hh>
+#include <distro/observer.hh>
+
+namespace distro {
+	namespace fs = std::filesystem;
+
+	inline std::string path_from(fs::path const& path) {
+		auto const u8gen = path.generic_u8string();
+#ifdef __cpp_lib_char8_t
+		return {reinterpret_cast<char const*>(u8gen.data()), u8gen.size()};
+#else
+		return u8gen;
+#endif
+	}
+
+	inline fs::path path_to(fs::path const& dir, std::string_view name) {
+#ifdef __cpp_lib_char8_t
+		return dir / std::u8string_view{
+		                 reinterpret_cast<char8_t const*>(name.data()),
+		                 name.size()};
+#else
+		return dir / fs::u8path(name.begin(), name.end());
+#endif
+	}
+
+	// calls visit(index) for each of the names accepted by the prefilter
+	// (all of them, if there is none)
+	template <typename Visitor>
+	void for_each_accepted(name_prefilter const* prefilter,
+	                       std::span<std::string_view const> names,
+	                       scan_stats& stats,
+	                       Visitor&& visit) {
+		for (size_t index = 0; index < names.size(); ++index) {
+			if (prefilter && !prefilter->accepts(names[index])) {
+				++stats.prefilter_rejections;
+				continue;
+			}
+			visit(index);
+		}
+	}
+
+#ifdef __linux__
+	// Reads raw getdents64 batches into a large buffer and hands out the
+	// names in place. Directories are told apart by d_type; only entries
+	// with DT_UNKNOWN or DT_LNK (is_directory follows the links) need
+	// a stat, which is put off until the name passes the prefilter.
+	class dirent_reader {
+	public:
+		explicit dirent_reader(fs::path const& srcdir);
+		~dirent_reader();
+		dirent_reader(dirent_reader const&) = delete;
+		dirent_reader& operator=(dirent_reader const&) = delete;
+
+		// replaces the names and types with the next batch of entries,
+		// other than known directories, which go to `directories`, if
+		// given; the views are valid until the next call; false at the
+		// end or on error
+		bool read(std::vector<std::string_view>& names,
+		          std::vector<unsigned char>& types,
+		          scan_stats& stats,
+		          std::vector<std::string_view>* directories = nullptr);
+		bool is_directory(std::string_view name,
+		                  unsigned char type,
+		                  scan_stats& stats) const;
+		std::error_code const& error() const noexcept { return ec_; }
+
+	private:
+		int fd_{-1};
+		std::error_code ec_{};
+		std::unique_ptr<std::uint64_t[]> buffer_;
+	};
+#endif
+
+	// calls visit(filename) for each entry of srcdir, which is not
+	// a directory and passes the prefilter, if there is one, and
+	// visit_dir(name) for each subdirectory, whose name is wanted, with
+	// views valid only during the call; counts the entries and the checks
+	// in stats
+	template <typename DirFilter, typename DirVisitor, typename Visitor>
+	std::error_code for_each_entry(fs::path const& srcdir,
+	                               scan_stats& stats,
+	                               name_prefilter const* prefilter,
+	                               DirFilter&& wanted,
+	                               DirVisitor&& visit_dir,
+	                               Visitor&& visit) {
+#ifdef __linux__
+		dirent_reader reader{srcdir};
+		std::vector<std::string_view> names{};
+		std::vector<unsigned char> types{};
+		std::vector<std::string_view> dirs{};
+		while (reader.read(names, types, stats, &dirs)) {
+			for (auto const name : dirs) {
+				if (wanted(name)) visit_dir(name);
+			}
+
+			// entries of unknown type with a wanted name could be
+			// directories, which the prefilter would turn down
+			for (size_t index = 0; index < names.size();) {
+				if (wanted(names[index]) &&
+				    reader.is_directory(names[index], types[index], stats)) {
+					visit_dir(names[index]);
+					names.erase(std::next(names.begin(),
+					                      static_cast<ptrdiff_t>(index)));
+					types.erase(std::next(types.begin(),
+					                      static_cast<ptrdiff_t>(index)));
+					continue;
+				}
+				++index;
+			}
+
+			for_each_accepted(prefilter, names, stats, [&](size_t index) {
+				if (reader.is_directory(names[index], types[index], stats))
+					return;
+				visit(names[index]);
+			});
+		}
+		return reader.error();
+#else
+		std::error_code ec;
+		fs::directory_iterator dirent{srcdir, ec};
+		if (ec) return ec;
+
+		// the iterator answers is_directory from what it read with the
+		// entry, where it can, and does not tell when it had to ask, so
+		// directory_checks stay at zero here
+		for (auto const& entry : dirent) {
+			++stats.entries;
+			if (entry.is_directory(ec)) {
+				auto const name = path_from(entry.path().filename());
+				if (wanted(std::string_view{name}))
+					visit_dir(std::string_view{name});
+				continue;
+			}
+			if (ec) continue;
+
+			auto const name = path_from(entry.path().filename());
+			if (prefilter && !prefilter->accepts(name)) {
+				++stats.prefilter_rejections;
+				continue;
+			}
+			visit(std::string_view{name});
+		}
+
+		return {};
+#endif
+	}
+
+	// same as for_each_entry, skipping all the subdirectories
+	template <typename Visitor>
+	std::error_code for_each_file(fs::path const& srcdir,
+	                              scan_stats& stats,
+	                              name_prefilter const* prefilter,
+	                              Visitor&& visit) {
+		return for_each_entry(
+		    srcdir, stats, prefilter, [](std::string_view) { return false; },
+		    [](std::string_view) {}, std::forward<Visitor>(visit));
+	}
+
+	template <typename Visitor>
+	std::error_code for_each_file(fs::path const& srcdir, Visitor&& visit) {
+		scan_stats ignored{};
+		return for_each_file(srcdir, ignored, nullptr,
+		                     std::forward<Visitor>(visit));
+	}
+}  // namespace distro
@@ -0,0 +1,421 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/extract.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "archive.hh"
+#include "dir_scan.hh"
+#include "mapped_file.hh"
+#include "phase_timer.hh"
+
+namespace distro {
+	namespace {
+		class extract_category_impl : public std::error_category {
+		public:
+			char const* name() const noexcept override {
+				return "distro::extract";
+			}
+
+			std::string message(int code) const override {
+				switch (static_cast<extract_errc>(code)) {
+					case extract_errc::unknown_format:
+						return "not an archive";
+					case extract_errc::unsupported_format:
+						return "archive compression not supported by this "
+						       "build";
+					case extract_errc::damaged_archive:
+						return "damaged archive";
+					case extract_errc::unsupported_entry:
+						return "archive entry not supported";
+					case extract_errc::unsafe_path:
+						return "archive entry outside of the destination";
+				}
+				return "unknown error";
+			}
+		};
+
+		std::error_code io_error() {
+			return std::make_error_code(std::errc::io_error);
+		}
+
+		std::error_code unsafe_path() {
+			return make_error_code(extract_errc::unsafe_path);
+		}
+
+		// Ranks of the archives, which placed the files; archive listed
+		// earlier replaces a file of the one listed later, never the other
+		// way round, so the result does not depend on the finishing order.
+		//
+		// Also keeps anything from being written through a link. Every
+		// directory something goes into, be it an entry or a link target,
+		// is checked once not to be a link and remembered; a link is never
+		// placed where such a directory is, and nothing goes into the
+		// links placed so far. Paths are relative to the destination.
+		class layers {
+		public:
+			explicit layers(fs::path const& dstdir) : dstdir_{dstdir} {}
+
+			// the directories leading to the path, with the path itself,
+			// if `inclusive`
+			std::error_code enter(std::string_view path, bool inclusive) {
+				std::lock_guard lock{mutex_};
+				return enter_locked(path, inclusive);
+			}
+
+			std::error_code place(fs::path const& temp,
+			                      fs::path const& target,
+			                      size_t rank) {
+				std::lock_guard lock{mutex_};
+				return place_locked(temp, target, rank);
+			}
+
+			std::error_code place_link(fs::path const& temp,
+			                           fs::path const& target,
+			                           std::string_view path,
+			                           std::vector<std::string> const& route,
+			                           size_t rank) {
+				std::lock_guard lock{mutex_};
+				if (dirs_.contains(std::string{path})) return unsafe_path();
+				for (auto const& dir : route) {
+					if (auto ec = enter_locked(dir, true)) return ec;
+				}
+
+				if (auto ec = place_locked(temp, target, rank)) return ec;
+				links_.emplace(path);
+				return {};
+			}
+
+		private:
+			std::error_code enter_locked(std::string_view path,
+			                             bool inclusive) {
+				std::error_code ignore{};
+				for (auto sep = path.find('/');;
+				     sep = path.find('/', sep + 1)) {
+					if (sep == std::string_view::npos && !inclusive) break;
+					auto const dir = std::string{path.substr(0, sep)};
+					if (!dir.empty() && !dirs_.contains(dir)) {
+						// a link from before the extraction counts, too
+						if (links_.contains(dir) ||
+						    fs::is_symlink(fs::symlink_status(
+						        path_to(dstdir_, dir), ignore)))
+							return unsafe_path();
+						dirs_.insert(dir);
+					}
+					if (sep == std::string_view::npos) break;
+				}
+				return {};
+			}
+
+			std::error_code place_locked(fs::path const& temp,
+			                             fs::path const& target,
+			                             size_t rank) {
+				std::error_code ec{};
+				auto [it, inserted] =
+				    owners_.try_emplace(target.native(), rank);
+				if (!inserted) {
+					if (it->second < rank) {
+						fs::remove(temp, ec);
+						return {};
+					}
+					it->second = rank;
+				}
+
+				fs::rename(temp, target, ec);
+				if (ec) {
+					std::error_code ignore{};
+					fs::remove(temp, ignore);
+				}
+				return ec;
+			}
+
+			fs::path const& dstdir_;
+			std::mutex mutex_{};
+			std::unordered_map<fs::path::string_type, size_t> owners_{};
+			// entered directories and placed links
+			std::unordered_set<std::string> dirs_{};
+			std::unordered_set<std::string> links_{};
+		};
+
+		// writes each entry next to its place and asks the layers to move
+		// it in
+		class directory_writer : public archive::entry_sink {
+		public:
+			directory_writer(fs::path const& dstdir,
+			                 size_t rank,
+			                 layers& files)
+			    : dstdir_{dstdir}, rank_{rank}, files_{files} {}
+
+			~directory_writer() {
+				std::error_code ignore{};
+				for (auto const& [path, own] : owned_)
+					fs::remove(own, ignore);
+				if (!out_.is_open()) return;
+				out_.close();
+				fs::remove(temp_, ignore);
+			}
+
+			directory_writer(directory_writer const&) = delete;
+			directory_writer& operator=(directory_writer const&) = delete;
+
+			std::error_code directory(std::string_view path) override {
+				if (auto ec = files_.enter(path, true)) return ec;
+
+				std::error_code ec{};
+				fs::create_directories(path_to(dstdir_, path), ec);
+				return ec;
+			}
+
+			std::error_code symlink(std::string_view path,
+			                        std::string_view target) override {
+				auto const route = archive::link_route(path, target);
+				if (!route) return unsafe_path();
+				if (auto ec = prepare(path)) return ec;
+
+				std::error_code ec{};
+				fs::create_symlink(path_to({}, target), temp_, ec);
+				if (ec) return ec;
+				ec = files_.place_link(temp_, target_, path, *route, rank_);
+				if (ec) {
+					std::error_code ignore{};
+					fs::remove(temp_, ignore);
+					return ec;
+				}
+				forget(path);
+				links_.emplace(path, target);
+				return {};
+			}
+
+			// Copies the entry this archive stored under the target, not
+			// whatever is there now: another archive may have replaced it,
+			// or may be about to.
+			std::error_code hardlink(std::string_view path,
+			                         std::string_view target) override {
+				auto const key = std::string{target};
+				if (auto it = links_.find(key); it != links_.end()) {
+					auto const link = it->second;
+					return symlink(path, link);
+				}
+				auto const it = owned_.find(key);
+				if (it == owned_.end())
+					return make_error_code(extract_errc::damaged_archive);
+				auto const own = it->second;
+
+				if (auto ec = prepare(path)) return ec;
+				std::error_code ec{};
+				fs::copy_file(own, temp_, ec);
+				if (ec) return ec;
+				if (auto err = keep_own()) return err;
+				return files_.place(temp_, target_, rank_);
+			}
+
+			std::error_code file_begin(std::string_view path,
+			                           std::uint32_t mode) override {
+				if (auto ec = prepare(path)) return ec;
+
+				mode_ = mode;
+				out_.open(temp_, std::ios::binary | std::ios::trunc);
+				if (!out_) return io_error();
+				return {};
+			}
+
+			std::error_code file_data(std::string_view chunk) override {
+				out_.write(chunk.data(),
+				           static_cast<std::streamsize>(chunk.size()));
+				if (!out_) return io_error();
+				return {};
+			}
+
+			std::error_code file_end() override {
+				out_.close();
+				if (!out_) return io_error();
+
+				std::error_code ec{};
+				// no set-user-ID and the like; on Windows, this only
+				// decides about the read-only attribute
+				if (mode_) {
+					fs::permissions(temp_,
+					                static_cast<fs::perms>(mode_ & 0777), ec);
+					if (ec) return ec;
+				}
+				if (auto err = keep_own()) return err;
+				return files_.place(temp_, target_, rank_);
+			}
+
+		private:
+			// Keeps a copy of the file about to be placed, named after the
+			// rank, so that the later hard links of this archive may still
+			// read it. The copies are removed with the writer.
+			std::error_code keep_own() {
+				auto own = target_;
+				own += ".distro-" + std::to_string(rank_) + ".own";
+				forget(path_);
+
+				std::error_code ec{};
+				fs::create_hard_link(temp_, own, ec);
+				if (ec) {
+					// left over by an interrupted run, or a filesystem
+					// without hard links
+					fs::remove(own, ec);
+					if (ec) return ec;
+					fs::create_hard_link(temp_, own, ec);
+					if (ec) fs::copy_file(temp_, own, ec);
+					if (ec) return ec;
+				}
+				owned_.emplace(path_, std::move(own));
+				return {};
+			}
+
+			// the path is about to hold something else
+			void forget(std::string const& path) {
+				links_.erase(path);
+				auto const it = owned_.find(path);
+				if (it == owned_.end()) return;
+				std::error_code ignore{};
+				fs::remove(it->second, ignore);
+				owned_.erase(it);
+			}
+			void forget(std::string_view path) { forget(std::string{path}); }
+
+			// the temporary name carries the rank, so that two archives
+			// writing the same file do not collide
+			std::error_code prepare(std::string_view path) {
+				if (auto ec = files_.enter(path, false)) return ec;
+
+				path_ = path;
+				target_ = path_to(dstdir_, path);
+				temp_ = target_;
+				temp_ += ".distro-" + std::to_string(rank_) + ".part";
+
+				std::error_code ec{};
+				fs::create_directories(target_.parent_path(), ec);
+				if (ec) return ec;
+				fs::remove(temp_, ec);
+				return ec;
+			}
+
+			fs::path const& dstdir_;
+			size_t rank_;
+			layers& files_;
+			std::string path_{};
+			fs::path target_{};
+			fs::path temp_{};
+			std::ofstream out_{};
+			std::uint32_t mode_{};
+			// what this archive stored so far, for its hard links: own
+			// copies of the files and targets of the symlinks
+			std::unordered_map<std::string, fs::path> owned_{};
+			std::unordered_map<std::string, std::string> links_{};
+		};
+
+		struct extraction {
+			std::error_code ec{};
+			// could not be opened; src_dir, not dst_dir
+			bool source{false};
+			// thrown while unpacking, rethrown after the workers are done
+			std::exception_ptr exception{};
+		};
+
+		extraction extract_one(fs::path const& archive,
+		                       fs::path const& dstdir,
+		                       size_t rank,
+		                       layers& files) {
+			std::error_code ec{};
+			if (!fs::is_regular_file(archive, ec)) {
+				if (!ec) ec = std::make_error_code(std::errc::invalid_argument);
+				return {ec, true};
+			}
+
+			mapped_file file{archive};
+			if (!file) return {io_error(), true};
+
+			directory_writer writer{dstdir, rank, files};
+			return {archive::unpack(file.view(), writer)};
+		}
+	}  // namespace
+
+	std::error_category const& extract_category() noexcept {
+		static extract_category_impl const category{};
+		return category;
+	}
+
+	void extract(std::span<fs::path const> archives,
+	             fs::path const& dstdir,
+	             errors const& log,
+	             unsigned threads,
+	             observer* obs) {
+		phase_timer timer{obs, phase::extract};
+
+		std::error_code ec{};
+		fs::create_directories(dstdir, ec);
+		if (ec) log.dst_dir(ec);
+
+		layers files{dstdir};
+		std::vector<extraction> results(archives.size());
+
+		std::atomic<size_t> next_archive{0};
+		auto const worker = [&] {
+			for (auto index = next_archive++; index < archives.size();
+			     index = next_archive++) {
+				try {
+					results[index] =
+					    extract_one(archives[index], dstdir, index, files);
+				} catch (...) {
+					results[index].exception = std::current_exception();
+				}
+			}
+		};
+
+		if (!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		auto const workers = std::min(size_t{threads}, archives.size());
+		if (workers > 1) {
+			std::vector<std::jthread> pool{};
+			pool.reserve(workers);
+			for (size_t index = 0; index < workers; ++index)
+				pool.emplace_back(worker);
+		} else {
+			worker();
+		}
+
+		// the log is not reentrant, so errors are reported once all threads
+		// are done, in the order of the archives
+		for (auto const& result : results) {
+			if (result.exception) std::rethrow_exception(result.exception);
+			if (!result.ec) continue;
+			if (result.source) log.src_dir(result.ec);
+			log.dst_dir(result.ec);
+		}
+	}
+
+	std::span<std::string_view const> extractable_extensions() noexcept {
+		static constexpr std::string_view extensions[] = {
+		    "zip",
+		    "tar",
+#ifdef DISTRO_HAS_ZLIB
+		    "tar.gz",
+		    "tgz",
+#endif
+#ifdef DISTRO_HAS_BZIP2
+		    "tar.bz2",
+		    "tbz2",
+#endif
+#ifdef DISTRO_HAS_LZMA
+		    "tar.xz",
+		    "txz",
+#endif
+		};
+		return extensions;
+	}
+}  // namespace distro
@@ -0,0 +1,212 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/file_matcher.hh>
+
+#include <iterator>
+
+namespace distro {
+	namespace {
+		constexpr bool is_digit(char c) noexcept {
+			return c >= '0' && c <= '9';
+		}
+
+		constexpr bool is_alpha(char c) noexcept {
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+		}
+
+		// [.0-9]
+		constexpr bool is_release(char c) noexcept {
+			return c == '.' || is_digit(c);
+		}
+
+		// [.0-9a-zA-Z-]
+		constexpr bool is_prerelease(char c) noexcept {
+			return c == '.' || c == '-' || is_digit(c) || is_alpha(c);
+		}
+
+		// FNV-1a
+		struct hasher {
+			std::uint64_t value{0xcbf29ce484222325};
+
+			void add(std::string_view view) {
+				for (auto c : view) {
+					value ^= static_cast<unsigned char>(c);
+					value *= 0x100000001b3;
+				}
+				// separator, so that {"ab", "c"} and {"a", "bc"} differ
+				value ^= 0xFF;
+				value *= 0x100000001b3;
+			}
+		};
+
+		template <typename Pred>
+		size_t skip_all(std::string_view view, size_t pos, Pred pred) {
+			while (pos < view.size() && pred(view[pos]))
+				++pos;
+			return pos;
+		}
+	}  // namespace
+
+	file_matcher::file_matcher(std::string_view package_name,
+	                           std::vector<std::string_view> const& platforms,
+	                           std::vector<std::string_view> const& extensions)
+	    : name_{package_name}, prefilter_{package_name, extensions} {
+		size_t index = 0;
+		for (auto platform : platforms)
+			platforms_.insert(platform.begin(), platform.end(), index++);
+
+		index = 0;
+		for (auto ext : extensions)
+			extensions_.insert(ext.rbegin(), ext.rend(), index++);
+
+		// empty alternation in the regex would match an empty string
+		static constexpr std::string_view empty{};
+		if (platforms.empty()) platforms_.insert(empty.begin(), empty.end(), 0);
+		if (extensions.empty())
+			extensions_.insert(empty.begin(), empty.end(), 0);
+
+		hasher hash{};
+		hash.add(package_name);
+		for (auto platform : platforms)
+			hash.add(platform);
+		hash.add({});
+		for (auto ext : extensions)
+			hash.add(ext);
+		fingerprint_ = hash.value;
+	}
+
+	std::optional<file_match> file_matcher::match(
+	    std::string_view filename) const {
+		auto const version_start = name_.size() + 1;
+		if (filename.size() <= version_start ||
+		    filename.substr(0, name_.size()) != name_ ||
+		    filename[name_.size()] != '-')
+			return std::nullopt;
+
+		// cheapest way to reject foreign files: there is no extension
+		bool has_extension = false;
+		extensions_.walk(filename.rbegin(), filename.rend(),
+		                 [&](size_t length, size_t) {
+			                 has_extension =
+			                     length < filename.size() &&
+			                     filename[filename.size() - length - 1] == '.';
+			                 return has_extension;
+		                 });
+		if (!has_extension) return std::nullopt;
+
+		auto const release_end = skip_all(filename, version_start, is_release);
+		if (release_end == version_start) return std::nullopt;
+
+		auto const result = [&](size_t version_end,
+		                        file_match&& match) -> file_match {
+			match.version =
+			    filename.substr(version_start, version_end - version_start);
+			return std::move(match);
+		};
+
+		// (?:-[.0-9a-zA-Z-]+)? is greedy, so longest prerelease goes first;
+		// the separator before platform must be one of the hyphens inside
+		if (release_end < filename.size() && filename[release_end] == '-') {
+			auto const end =
+			    skip_all(filename, release_end + 1, is_prerelease);
+			for (auto sep = end; sep > release_end + 2;) {
+				--sep;
+				if (filename[sep] != '-') continue;
+				if (auto match = match_platform(filename, sep))
+					return result(sep, std::move(*match));
+			}
+		}
+
+		if (auto match = match_platform(filename, release_end))
+			return result(release_end, std::move(*match));
+
+		return std::nullopt;
+	}
+
+	std::optional<file_match> file_matcher::match_platform(
+	    std::string_view filename,
+	    size_t separator) const {
+		if (separator >= filename.size() || filename[separator] != '-')
+			return std::nullopt;
+
+		auto const start = separator + 1;
+		auto const rest = filename.substr(start);
+
+		// alternation tries the platforms in the order of the list, no
+		// matter how long each of them is
+		size_t lowest = 0;
+		while (true) {
+			size_t token = token_trie::npos;
+			size_t length = 0;
+			platforms_.walk(rest.begin(), rest.end(),
+			                [&](size_t len, size_t tok) {
+				                if (tok >= lowest && tok < token) {
+					                token = tok;
+					                length = len;
+				                }
+				                return false;
+			                });
+			if (token == token_trie::npos) return std::nullopt;
+			lowest = token + 1;
+
+			if (auto match = match_component(filename, start + length)) {
+				match->arch = rest.substr(0, length);
+				return match;
+			}
+		}
+	}
+
+	std::optional<file_match> file_matcher::match_component(
+	    std::string_view filename,
+	    size_t pos) const {
+		if (pos < filename.size() && filename[pos] == '-') {
+			auto const comp_start = pos + 1;
+			auto const comp_end = skip_all(filename, comp_start, is_alpha);
+			if (comp_end > comp_start) {
+				auto const comp =
+				    filename.substr(comp_start, comp_end - comp_start);
+
+				if (comp_end < filename.size() && filename[comp_end] == '-') {
+					// [0-9.]+ is greedy, so it will give back only as much,
+					// as needed by the extension
+					auto const ver_start = comp_end + 1;
+					auto const ver_end =
+					    skip_all(filename, ver_start, is_release);
+					for (auto ext = ver_end; ext > ver_start + 1;) {
+						--ext;
+						if (is_extension_at(filename, ext))
+							return file_match{
+							    {},
+							    {},
+							    comp,
+							    filename.substr(ver_start, ext - ver_start)};
+					}
+				}
+
+				if (is_extension_at(filename, comp_end))
+					return file_match{{}, {}, comp};
+			}
+		}
+
+		if (is_extension_at(filename, pos)) return file_match{};
+		return std::nullopt;
+	}
+
+	bool file_matcher::is_extension_at(std::string_view filename,
+	                                   size_t pos) const {
+		if (pos >= filename.size() || filename[pos] != '.') return false;
+
+		auto const length = filename.size() - pos - 1;
+		bool found = false;
+		extensions_.walk(
+		    filename.rbegin(),
+		    std::next(filename.rbegin(), static_cast<ptrdiff_t>(length)),
+		    [&](size_t len, size_t) {
+			    found = len == length;
+			    return found;
+		    });
+		return found;
+	}
+}  // namespace distro
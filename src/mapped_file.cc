@@ -0,0 +1,93 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "mapped_file.hh"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace distro {
+#ifdef _WIN32
+	mapped_file::mapped_file(fs::path const& path) {
+		auto file = CreateFileW(path.c_str(), GENERIC_READ,
+		                        FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+		                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			return;
+		}
+
+		if (size.QuadPart) {
+			auto mapping =
+			    CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping) {
+				data_ = static_cast<char const*>(
+				    MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				// the view keeps the mapping alive
+				CloseHandle(mapping);
+			}
+			if (data_) size_ = static_cast<size_t>(size.QuadPart);
+		}
+		valid_ = data_ || !size.QuadPart;
+		CloseHandle(file);
+	}
+
+	void mapped_file::unmap() noexcept {
+		if (data_) UnmapViewOfFile(data_);
+	}
+#else
+	mapped_file::mapped_file(fs::path const& path) {
+		auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return;
+
+		struct stat st {};
+		if (::fstat(fd, &st) == 0) {
+			auto const size = static_cast<size_t>(st.st_size);
+			if (size) {
+				auto ptr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+				if (ptr != MAP_FAILED) {
+					data_ = static_cast<char const*>(ptr);
+					size_ = size;
+				}
+			}
+			valid_ = data_ || !size;
+		}
+		::close(fd);
+	}
+
+	void mapped_file::unmap() noexcept {
+		if (data_) ::munmap(const_cast<char*>(data_), size_);
+	}
+#endif
+
+	mapped_file::~mapped_file() { unmap(); }
+
+	mapped_file::mapped_file(mapped_file&& other) noexcept
+	    : data_{std::exchange(other.data_, nullptr)}
+	    , size_{std::exchange(other.size_, 0)}
+	    , valid_{std::exchange(other.valid_, false)} {}
+
+	mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+			valid_ = std::exchange(other.valid_, false);
+		}
+		return *this;
+	}
+}  // namespace distro
@@ -0,0 +1,35 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+
+namespace distro {
+	namespace fs = std::filesystem;
+
+	// read-only view of a whole file; falls to an invalid state, if the file
+	// could not be opened or mapped
+	class mapped_file {
+	public:
+		mapped_file() = default;
+		explicit mapped_file(fs::path const& path);
+		~mapped_file();
+		mapped_file(mapped_file&&) noexcept;
+		mapped_file& operator=(mapped_file&&) noexcept;
+		mapped_file(mapped_file const&) = delete;
+		mapped_file& operator=(mapped_file const&) = delete;
+
+		explicit operator bool() const noexcept { return valid_; }
+		std::string_view view() const noexcept { return {data_, size_}; }
+
+	private:
+		void unmap() noexcept;
+
+		char const* data_{nullptr};
+		size_t size_{0};
+		bool valid_{false};
+	};
+}  // namespace distro
@@ -0,0 +1,132 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/name_prefilter.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DISTRO_PREFILTER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace distro {
+	namespace {
+#if defined(__AVX2__)
+		constexpr size_t width = 32;
+
+		// bit N set, if data[N] == pattern[N]
+		std::uint32_t equal_bytes(char const* data, char const* pattern) {
+			auto const lhs = _mm256_loadu_si256(
+			    static_cast<__m256i const*>(static_cast<void const*>(data)));
+			auto const rhs = _mm256_loadu_si256(
+			    static_cast<__m256i const*>(static_cast<void const*>(pattern)));
+			return static_cast<std::uint32_t>(
+			    _mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+		}
+#elif defined(DISTRO_PREFILTER_SSE2)
+		constexpr size_t width = 16;
+
+		std::uint32_t equal_bytes(char const* data, char const* pattern) {
+			auto const lhs = _mm_loadu_si128(
+			    static_cast<__m128i const*>(static_cast<void const*>(data)));
+			auto const rhs = _mm_loadu_si128(
+			    static_cast<__m128i const*>(static_cast<void const*>(pattern)));
+			return static_cast<std::uint32_t>(
+			    _mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs)));
+		}
+#else
+		constexpr size_t width = 0;
+
+		std::uint32_t equal_bytes(char const*, char const*) { return 0; }
+#endif
+
+		// lowest `count` bits of a width-bit mask
+		constexpr std::uint32_t low_bits(size_t count) noexcept {
+			return count >= 32 ? ~std::uint32_t{}
+			                   : (std::uint32_t{1} << count) - 1;
+		}
+
+		// highest `count` bits of a width-bit mask
+		constexpr std::uint32_t high_bits(size_t count) noexcept {
+			return low_bits(count) << (width - count);
+		}
+	}  // namespace
+
+	name_prefilter::name_prefilter(
+	    std::string_view package_name,
+	    std::vector<std::string_view> const& extensions)
+	    : prefix_{package_name} {
+		prefix_.push_back('-');
+		std::copy_n(prefix_.begin(), std::min(prefix_.size(), max_width),
+		            prefix_pattern_.begin());
+
+		// the matcher treats no extensions as a single empty one
+		static constexpr std::string_view empty{};
+		auto const& exts = extensions.empty()
+		                       ? std::vector<std::string_view>{empty}
+		                       : extensions;
+
+		auto shortest = std::string::npos;
+		suffixes_.reserve(exts.size());
+		suffix_patterns_.reserve(exts.size());
+		for (auto ext : exts) {
+			auto& suffix = suffixes_.emplace_back(1, '.');
+			suffix.append(ext);
+			shortest = std::min(shortest, suffix.size());
+
+			auto& pat = suffix_patterns_.emplace_back();
+			auto const length = std::min(suffix.size(), max_width);
+			std::copy_n(suffix.end() - static_cast<ptrdiff_t>(length),
+			            length, pat.end() - static_cast<ptrdiff_t>(length));
+		}
+
+		// the version takes at least one character
+		min_size_ = prefix_.size() + 1 + shortest;
+	}
+
+	bool name_prefilter::accepts(std::string_view name) const noexcept {
+		return name.size() >= min_size_ && has_prefix(name) &&
+		       has_suffix(name);
+	}
+
+	bool name_prefilter::has_prefix(std::string_view name) const noexcept {
+		if constexpr (width > 0) {
+			if (name.size() >= width) {
+				auto const head = std::min(prefix_.size(), width);
+				auto const mask = low_bits(head);
+				if ((equal_bytes(name.data(), prefix_pattern_.data()) &
+				     mask) != mask)
+					return false;
+				return prefix_.size() <= width ||
+				       name.substr(head, prefix_.size() - head) ==
+				           std::string_view{prefix_}.substr(head);
+			}
+		}
+		return name.starts_with(prefix_);
+	}
+
+	bool name_prefilter::has_suffix(std::string_view name) const noexcept {
+		for (size_t index = 0; index < suffixes_.size(); ++index) {
+			auto const& suffix = suffixes_[index];
+			if constexpr (width > 0) {
+				if (name.size() >= width && suffix.size() <= width) {
+					auto const mask = high_bits(suffix.size());
+					auto const* tail = name.data() + name.size() - width;
+					auto const* pat =
+					    suffix_patterns_[index].data() + max_width - width;
+					if ((equal_bytes(tail, pat) & mask) == mask) return true;
+					continue;
+				}
+			}
+			if (name.ends_with(suffix)) return true;
+		}
+		return false;
+	}
+}  // namespace distro
@@ -0,0 +1,38 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/observer.hh>
+
+namespace distro {
+	scan_stats& scan_stats::operator+=(scan_stats const& other) noexcept {
+		entries += other.entries;
+		directory_checks += other.directory_checks;
+		prefilter_rejections += other.prefilter_rejections;
+		name_rejections += other.name_rejections;
+		semver_failures += other.semver_failures;
+		misplaced += other.misplaced;
+		arch_rejections += other.arch_rejections;
+		packages_kept += other.packages_kept;
+		subtrees_pruned += other.subtrees_pruned;
+		return *this;
+	}
+
+	double scan_stats::prefilter_rejection_rate() const noexcept {
+		if (!entries) return 0;
+		return static_cast<double>(prefilter_rejections) /
+		       static_cast<double>(entries);
+	}
+
+	observer::~observer() = default;
+
+	void statistics::scanned(fs::path const&, scan_stats const& stats) {
+		scan += stats;
+	}
+
+	void statistics::timed(phase which, duration elapsed) {
+		auto const index = static_cast<size_t>(which);
+		time[index] += elapsed;
+		++calls[index];
+	}
+}  // namespace distro
@@ -8,32 +8,101 @@
 using namespace std::literals;
 
 namespace distro {
-	std::optional<package> package::from_string(fs::path const& archive,
-	                                            std::string_view view,
-	                                            std::regex const& matcher) {
+	namespace {
+		std::optional<semver> copy_of(std::optional<semver> const& version,
+		                              semver::allocator_type const& alloc) {
+			if (!version) return std::nullopt;
+			return semver{*version, alloc};
+		}
+
+		std::optional<semver> move_of(std::optional<semver>&& version,
+		                              semver::allocator_type const& alloc) {
+			if (!version) return std::nullopt;
+			return semver{std::move(*version), alloc};
+		}
+	}  // namespace
+
+	package::package(allocator_type const& alloc)
+	    : filename{alloc}, version{alloc} {}
+
+	package::package(package const& other, allocator_type const& alloc)
+	    : filename{other.filename, alloc}
+	    , version{other.version, alloc}
+	    , arch{other.arch}
+	    , root{other.root} {
+		if (other.comp)
+			comp = component{other.comp->name,
+			                 copy_of(other.comp->version, alloc)};
+	}
+
+	package::package(package&& other, allocator_type const& alloc)
+	    : filename{std::move(other.filename), alloc}
+	    , version{std::move(other.version), alloc}
+	    , arch{other.arch}
+	    , root{other.root} {
+		if (other.comp)
+			comp = component{other.comp->name,
+			                 move_of(std::move(other.comp->version), alloc)};
+	}
+
+	std::optional<package> package::from_string(std::string_view view,
+	                                            std::regex const& matcher,
+	                                            symbol_table& table,
+	                                            allocator_type const& alloc) {
+		auto captures = match(view, matcher);
+		if (!captures) return std::nullopt;
+		return from_match(view, *captures, table, alloc);
+	}
+
+	std::optional<package> package::from_string(std::string_view view,
+	                                            file_matcher const& matcher,
+	                                            symbol_table& table,
+	                                            allocator_type const& alloc) {
+		auto captures = match(view, matcher);
+		if (!captures) return std::nullopt;
+		return from_match(view, *captures, table, alloc);
+	}
+
+	std::optional<file_match> package::match(std::string_view view,
+	                                         std::regex const& matcher) {
 		svmatch match{};
-		if (std::regex_match(view.begin(), view.end(), match, matcher)) {
-			auto& version = match[1];
-			auto& arch = match[2];
-			auto& comp = match[3];
-			auto& compver = match[4];
-
-			auto ver = semver::from_string(to_view(version));
-			if (!ver) return std::nullopt;
-
-			package pkg{archive, std::move(*ver), arch.str()};
-			pkg.archive.make_preferred();
-
-			if (comp.matched) {
-				std::optional<semver> cver{};
-				if (compver.matched) {
-					cver = semver::from_string(to_view(compver));
-					if (!cver) return std::nullopt;
-				}
-				pkg.comp = component{comp.str(), std::move(cver)};
+		if (!std::regex_match(view.begin(), view.end(), match, matcher))
+			return std::nullopt;
+
+		auto const optional = [](svsub_match const& capture) {
+			return capture.matched ? std::optional{to_view(capture)}
+			                       : std::nullopt;
+		};
+
+		return file_match{to_view(match[1]), to_view(match[2]),
+		                  optional(match[3]), optional(match[4])};
+	}
+
+	std::optional<file_match> package::match(std::string_view view,
+	                                         file_matcher const& matcher) {
+		return matcher.match(view);
+	}
+
+	std::optional<package> package::from_match(std::string_view view,
+	                                           file_match const& match,
+	                                           symbol_table& table,
+	                                           allocator_type const& alloc) {
+		auto ver = semver::from_string(match.version, alloc);
+		if (!ver) return std::nullopt;
+
+		package pkg{alloc};
+		pkg.filename = view;
+		pkg.version = std::move(*ver);
+		pkg.arch = table.intern(match.arch);
+
+		if (match.comp) {
+			std::optional<semver> cver{};
+			if (match.compver) {
+				cver = semver::from_string(*match.compver, alloc);
+				if (!cver) return std::nullopt;
 			}
-			return pkg;
+			pkg.comp = component{table.intern(*match.comp), std::move(cver)};
 		}
-		return std::nullopt;
+		return pkg;
 	}
 }  // namespace distro
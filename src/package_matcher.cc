@@ -0,0 +1,36 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/package_matcher.hh>
+
+namespace distro {
+	package_matcher::package_matcher(
+	    std::vector<std::string_view> const& package_names,
+	    std::vector<std::string_view> const& platforms,
+	    std::vector<std::string_view> const& extensions) {
+		names_.reserve(package_names.size());
+		matchers_.reserve(package_names.size());
+		for (auto name : package_names) {
+			prefixes_.insert(name.begin(), name.end(), names_.size());
+			names_.emplace_back(name);
+			matchers_.emplace_back(name, platforms, extensions);
+		}
+	}
+
+	std::optional<package_match> package_matcher::match(
+	    std::string_view filename) const {
+		std::optional<package_match> result{};
+		prefixes_.walk(filename.begin(), filename.end(),
+		               [&](size_t length, size_t token) {
+			               if (length >= filename.size() ||
+			                   filename[length] != '-')
+				               return false;
+			               auto captures = matchers_[token].match(filename);
+			               if (!captures) return false;
+			               result = package_match{token, std::move(*captures)};
+			               return true;
+		               });
+		return result;
+	}
+}  // namespace distro
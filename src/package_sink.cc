@@ -0,0 +1,11 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/package_sink.hh>
+
+namespace distro {
+	package_sink::~package_sink() = default;
+
+	void package_sink::matched(package const&, symbol_table const&) {}
+}  // namespace distro
@@ -0,0 +1,50 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/package_source.hh>
+
+#include "dir_scan.hh"
+#include "mapped_file.hh"
+
+namespace distro {
+	package_source::~package_source() = default;
+
+	std::error_code directory_source::for_each_name(visitor const& visit,
+	                                                scan_stats& stats) const {
+		return for_each_file(root(), stats, prefilter(), visit);
+	}
+
+	std::error_code manifest_source::for_each_name(visitor const& visit,
+	                                               scan_stats& stats) const {
+		mapped_file file{manifest_};
+		if (!file) {
+			std::error_code ec;
+			if (!fs::exists(manifest_, ec) && !ec)
+				ec = std::make_error_code(std::errc::no_such_file_or_directory);
+			if (!ec) ec = std::make_error_code(std::errc::io_error);
+			return ec;
+		}
+
+		auto const* filter = prefilter();
+		auto listing = file.view();
+		while (!listing.empty()) {
+			auto const eol = listing.find('\n');
+			auto name = listing.substr(0, eol);
+			listing.remove_prefix(eol == std::string_view::npos ? listing.size()
+			                                                    : eol + 1);
+
+			if (!name.empty() && name.back() == '\r') name.remove_suffix(1);
+			if (name.empty()) continue;
+
+			++stats.entries;
+			if (filter && !filter->accepts(name)) {
+				++stats.prefilter_rejections;
+				continue;
+			}
+			visit(name);
+		}
+
+		return {};
+	}
+}  // namespace distro
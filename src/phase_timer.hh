@@ -0,0 +1,32 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <chrono>
+
+#include <distro/observer.hh>
+
+namespace distro {
+	// reports the time between construction and destruction, if there
+	// is anyone to report to
+	class phase_timer {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		phase_timer(observer* obs, phase which) : obs_{obs}, which_{which} {
+			if (obs_) start_ = clock::now();
+		}
+		~phase_timer() {
+			if (obs_) obs_->timed(which_, clock::now() - start_);
+		}
+		phase_timer(phase_timer const&) = delete;
+		phase_timer& operator=(phase_timer const&) = delete;
+
+	private:
+		observer* obs_;
+		phase which_;
+		clock::time_point start_{};
+	};
+}  // namespace distro
@@ -58,6 +58,28 @@ namespace distro {
 
 			return result;
 		}
+
+		// the name_prefilter compares the name and the extensions as they
+		// are, while here they become a part of the regex; the dots of
+		// the extensions are escaped above
+		bool is_literal(std::string_view view, std::string_view escaped) {
+			static constexpr auto special = "\\^$.|?*+()[]{}"sv;
+			for (auto c : view) {
+				if (special.find(c) != std::string_view::npos &&
+				    escaped.find(c) == std::string_view::npos)
+					return false;
+			}
+			return true;
+		}
+
+		bool prefilter_fits(std::string_view package_name,
+		                    std::vector<std::string_view> const& extensions) {
+			if (!is_literal(package_name, {})) return false;
+			for (auto ext : extensions) {
+				if (!is_literal(ext, "."sv)) return false;
+			}
+			return true;
+		}
 	}  // namespace
 
 	std::vector<std::string_view> regex::platforms() {
@@ -65,7 +87,7 @@ namespace distro {
 		        "anywhere"};
 	}
 
-	std::regex build_file_matcher(
+	regex_matcher build_file_matcher(
 	    std::string_view package_name,
 	    std::vector<std::string_view> const& platforms,
 	    std::vector<std::string_view> const& extensions) {
@@ -90,6 +112,9 @@ namespace distro {
 		code.append(exts);
 		code.append(suffix);
 
-		return std::regex{code, std::regex::ECMAScript | std::regex::optimize};
+		std::regex regex{code, std::regex::ECMAScript | std::regex::optimize};
+		if (!prefilter_fits(package_name, extensions))
+			return regex_matcher{std::move(regex)};
+		return {std::move(regex), name_prefilter{package_name, extensions}};
 	}
 }  // namespace distro
@@ -0,0 +1,352 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/versions.hh>
+
+#include <algorithm>
+#include <ostream>
+
+namespace distro {
+	namespace {
+		class ansi_renderer {
+		public:
+			ansi_renderer(versions const& parent, std::string& out)
+			    : parent_{parent}, out_{out} {}
+
+			void missing(symbol comp) {
+				if (!any_missing_) out_ += "Possibly-missing component(s):";
+				any_missing_ = true;
+				out_ += ' ';
+				out_ += parent_.name(comp);
+			}
+
+			void versions_begin() {
+				if (any_missing_) out_ += "\n\n";
+			}
+
+			void version(semver const& ver,
+			             report_state state,
+			             bool mixed_arch,
+			             size_t) {
+				switch (state) {
+					case report_state::selected:
+						out_ += "\x1b[96m";
+						break;
+					case report_state::provider:
+						out_ += "\x1b[36m";
+						break;
+					case report_state::unused:
+						out_ += "\x1b[90m";
+						break;
+				}
+				out_ += ver.to_string();
+				out_ += "\x1b[0m";
+
+				selected_version_ = state == report_state::selected;
+				mixed_arch_ = mixed_arch;
+				separator_ = ':';
+			}
+
+			void package(distro::package const& pkg, bool selected) {
+				out_ += separator_;
+				out_ += ' ';
+				separator_ = ',';
+
+				if (selected)
+					out_ += selected_version_ ? "\x1b[92m" : "\x1b[32m";
+				if (pkg.comp) {
+					out_ += parent_.name(pkg.comp->name);
+					if (pkg.comp->version) {
+						out_ += '-';
+						out_ += pkg.comp->version->to_string();
+					}
+				} else {
+					out_ += "main";
+				}
+				if (selected) out_ += "\x1b[0m";
+
+				if (mixed_arch_) {
+					out_ += " (";
+					out_ += parent_.name(pkg.arch);
+					out_ += ')';
+				}
+			}
+
+			void version_end() { out_ += '\n'; }
+			void finish() { out_ += '\n'; }
+
+		private:
+			versions const& parent_;
+			std::string& out_;
+			bool any_missing_{false};
+			bool selected_version_{false};
+			bool mixed_arch_{false};
+			char separator_{':'};
+		};
+
+		std::string_view state_name(report_state state) {
+			switch (state) {
+				case report_state::selected:
+					return "selected";
+				case report_state::provider:
+					return "provider";
+				case report_state::unused:
+					break;
+			}
+			return "unused";
+		}
+
+		class json_renderer {
+		public:
+			json_renderer(versions const& parent, std::string& out)
+			    : parent_{parent}, out_{out} {
+				out_ += "{\"missing\":[";
+			}
+
+			void missing(symbol comp) {
+				next();
+				string(parent_.name(comp));
+			}
+
+			void versions_begin() {
+				out_ += "],\"versions\":[";
+				first_ = true;
+			}
+
+			void version(semver const& ver,
+			             report_state state,
+			             bool,
+			             size_t) {
+				next();
+				out_ += "{\"version\":";
+				string(ver.to_string());
+				out_ += ",\"state\":";
+				string(state_name(state));
+				out_ += ",\"packages\":[";
+				first_ = true;
+			}
+
+			void package(distro::package const& pkg, bool selected) {
+				next();
+				out_ += "{\"file\":";
+				string(pkg.filename);
+				out_ += ",\"arch\":";
+				string(parent_.name(pkg.arch));
+				out_ += ",\"component\":";
+				if (pkg.comp) {
+					string(parent_.name(pkg.comp->name));
+					if (pkg.comp->version) {
+						out_ += ",\"component_version\":";
+						string(pkg.comp->version->to_string());
+					}
+				} else {
+					out_ += "null";
+				}
+				out_ += ",\"selected\":";
+				out_ += selected ? "true" : "false";
+				out_ += '}';
+			}
+
+			void version_end() {
+				out_ += "]}";
+				first_ = false;
+			}
+
+			void finish() { out_ += "]}\n"; }
+
+		private:
+			void next() {
+				if (!first_) out_ += ',';
+				first_ = false;
+			}
+
+			// names are UTF-8 already, only the quotes, backslashes and
+			// control characters need escaping
+			void string(std::string_view text) {
+				static constexpr char hex[] = "0123456789abcdef";
+				out_ += '"';
+				while (!text.empty()) {
+					auto const plain = std::find_if(
+					    text.begin(), text.end(), [](char c) {
+						    return c == '"' || c == '\\' ||
+						           static_cast<unsigned char>(c) < 0x20;
+					    });
+					auto const length =
+					    static_cast<size_t>(plain - text.begin());
+					out_.append(text.data(), length);
+					text.remove_prefix(length);
+					if (text.empty()) break;
+
+					auto const uc = static_cast<unsigned char>(text.front());
+					text.remove_prefix(1);
+					if (uc == '"' || uc == '\\') {
+						out_ += '\\';
+						out_ += static_cast<char>(uc);
+					} else {
+						out_ += "\\u00";
+						out_ += hex[uc >> 4];
+						out_ += hex[uc & 0xF];
+					}
+				}
+				out_ += '"';
+			}
+
+			versions const& parent_;
+			std::string& out_;
+			bool first_{true};
+		};
+
+		class binary_renderer {
+		public:
+			binary_renderer(versions const& parent, std::string& out)
+			    : parent_{parent}, out_{out} {
+				out_.append(report_magic, sizeof(report_magic));
+			}
+
+			void missing(symbol comp) {
+				tag(report_record::missing);
+				string(parent_.name(comp));
+			}
+
+			void versions_begin() {}
+
+			void version(semver const& ver,
+			             report_state state,
+			             bool mixed_arch,
+			             size_t count) {
+				tag(report_record::version);
+				byte(static_cast<std::uint8_t>(state));
+				byte(mixed_arch ? report_version_flags::mixed_arch : 0);
+				string(ver.to_string());
+				number(count);
+			}
+
+			void package(distro::package const& pkg, bool selected) {
+				namespace flags = report_package_flags;
+				std::uint8_t bits = selected ? flags::selected : 0;
+				if (pkg.comp) {
+					bits |= flags::component;
+					if (pkg.comp->version) bits |= flags::component_version;
+				}
+
+				tag(report_record::package);
+				byte(bits);
+				string(pkg.filename);
+				string(parent_.name(pkg.arch));
+				if (pkg.comp) {
+					string(parent_.name(pkg.comp->name));
+					if (pkg.comp->version)
+						string(pkg.comp->version->to_string());
+				}
+			}
+
+			void version_end() {}
+			void finish() { tag(report_record::end); }
+
+		private:
+			void byte(std::uint8_t value) {
+				out_ += static_cast<char>(value);
+			}
+
+			void tag(report_record record) {
+				byte(static_cast<std::uint8_t>(record));
+			}
+
+			void number(size_t value) {
+				while (value >= 0x80) {
+					byte(static_cast<std::uint8_t>(value | 0x80));
+					value >>= 7;
+				}
+				byte(static_cast<std::uint8_t>(value));
+			}
+
+			void string(std::string_view text) {
+				number(text.size());
+				out_ += text;
+			}
+
+			versions const& parent_;
+			std::string& out_;
+		};
+	}  // namespace
+
+	template <typename Renderer>
+	void versions::comp_list::render(Renderer& renderer) const {
+		auto const& parent = *parent_;
+
+		std::vector<bool> chosen(parent.packages.size());
+		for (auto const* pkg : chosen_)
+			chosen[static_cast<size_t>(pkg - parent.packages.data())] = true;
+
+		missing_.for_each([&](symbol comp) { renderer.missing(comp); });
+		renderer.versions_begin();
+
+		auto const selected_index =
+		    static_cast<size_t>(selected_ - parent.items.begin());
+		for (size_t index = 0; index < parent.items.size(); ++index) {
+			auto const& [ver, run] = parent.items[index];
+			auto const first =
+			    static_cast<size_t>(run.data() - parent.packages.data());
+			auto const listed = std::span{parent.listing}.subspan(
+			    first, run.size());
+
+			// what the version line needs to know about the packages
+			// before they are listed
+			size_t count{};
+			bool any_chosen = false;
+			bool mixed_arch = false;
+			symbol arch{};
+			for (auto const pos : listed) {
+				auto const& pkg = parent.packages[pos];
+				if (!architectures_.accepts(pkg.arch)) continue;
+				if (count && pkg.arch != arch) mixed_arch = true;
+				arch = pkg.arch;
+				any_chosen |= chosen[pos];
+				++count;
+			}
+			if (!count) continue;
+
+			auto const state = index == selected_index ? report_state::selected
+			                   : any_chosen            ? report_state::provider
+			                                           : report_state::unused;
+			renderer.version(ver, state, mixed_arch, count);
+			for (auto const pos : listed) {
+				auto const& pkg = parent.packages[pos];
+				if (!architectures_.accepts(pkg.arch)) continue;
+				renderer.package(pkg, chosen[pos]);
+			}
+			renderer.version_end();
+		}
+
+		renderer.finish();
+	}
+
+	void versions::comp_list::report(report_format format,
+	                                 std::string& out) const {
+		switch (format) {
+			case report_format::ansi: {
+				ansi_renderer renderer{*parent_, out};
+				render(renderer);
+				break;
+			}
+			case report_format::json: {
+				json_renderer renderer{*parent_, out};
+				render(renderer);
+				break;
+			}
+			case report_format::binary: {
+				binary_renderer renderer{*parent_, out};
+				render(renderer);
+				break;
+			}
+		}
+	}
+
+	void versions::comp_list::report(report_format format,
+	                                 std::ostream& out) const {
+		std::string buffer{};
+		report(format, buffer);
+		out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+	}
+}  // namespace distro
@@ -0,0 +1,312 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/repository.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "phase_timer.hh"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace distro {
+	namespace {
+		bool by_version(package const& lhs, package const& rhs) {
+			return lhs.version < rhs.version;
+		}
+
+#ifdef __linux__
+		std::error_code last_error() {
+			return {errno, std::generic_category()};
+		}
+
+		void close_fd(int& fd) {
+			if (fd >= 0) ::close(fd);
+			fd = -1;
+		}
+#endif
+	}  // namespace
+
+	repository::repository(fs::path srcdir,
+	                       StringSet architectures,
+	                       regex_matcher const& matcher,
+	                       errors const& log,
+	                       observer* obs)
+	    : repository{std::move(srcdir),
+	                 std::move(architectures),
+	                 [matcher](std::string_view name) {
+		                 return package::match(name, matcher);
+	                 },
+	                 std::optional<name_prefilter>{matcher.prefilter()},
+	                 log,
+	                 obs} {}
+
+	repository::repository(fs::path srcdir,
+	                       StringSet architectures,
+	                       file_matcher const& matcher,
+	                       errors const& log,
+	                       observer* obs)
+	    : repository{std::move(srcdir),
+	                 std::move(architectures),
+	                 [matcher](std::string_view name) {
+		                 return package::match(name, matcher);
+	                 },
+	                 matcher.prefilter(),
+	                 log,
+	                 obs} {}
+
+	repository::repository(fs::path&& srcdir,
+	                       StringSet&& architectures,
+	                       matcher_type&& matcher,
+	                       std::optional<name_prefilter>&& prefilter,
+	                       errors const& log,
+	                       observer* obs)
+	    : srcdir_{std::move(srcdir)}
+	    , architectures_{std::move(architectures)}
+	    , match_{std::move(matcher)}
+	    , prefilter_{std::move(prefilter)} {
+		filter_ = arch_filter{architectures_, table_};
+
+#ifdef __linux__
+		// the watch goes first, so that nothing created during the scan
+		// is missed; anything seen twice is added once. Without it, the
+		// set is still served and updated by refresh().
+		watch_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		// files are taken once their writer closes them, not when they
+		// are created, so that no half-written archive is published
+		if (watch_fd_ < 0 ||
+		    ::inotify_add_watch(watch_fd_, srcdir_.c_str(),
+		                        IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM |
+		                            IN_MOVED_TO | IN_DELETE_SELF |
+		                            IN_MOVE_SELF | IN_ONLYDIR) < 0 ||
+		    (wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+			watch_error_ = last_error();
+			close_fd(watch_fd_);
+			close_fd(wake_fd_);
+		}
+#else
+		watch_error_ = std::make_error_code(std::errc::not_supported);
+#endif
+
+		scan_stats stats{};
+		std::error_code ec{};
+		{
+			phase_timer timer{obs, phase::scan};
+			ec = rescan(stats);
+		}
+		if (obs) obs->scanned(srcdir_, stats);
+		if (ec) {
+#ifdef __linux__
+			close_fd(watch_fd_);
+			close_fd(wake_fd_);
+#endif
+			log.src_dir(ec);
+		}
+
+		{
+			phase_timer timer{obs, phase::index};
+			publish();
+		}
+
+#ifdef __linux__
+		if (watch_fd_ >= 0) {
+			watcher_ =
+			    std::jthread{[this](std::stop_token stop) { watch(stop); }};
+		}
+#endif
+	}
+
+	repository::~repository() {
+#ifdef __linux__
+		if (watcher_.joinable()) {
+			watcher_.request_stop();
+			std::uint64_t const one = 1;
+			[[maybe_unused]] auto const ignore =
+			    ::write(wake_fd_, &one, sizeof(one));
+			watcher_.join();
+		}
+		close_fd(watch_fd_);
+		close_fd(wake_fd_);
+#endif
+	}
+
+	std::error_code repository::refresh() {
+		std::lock_guard lock{update_mutex_};
+		scan_stats stats{};
+		auto const ec = rescan(stats);
+		if (!ec) publish();
+		return ec;
+	}
+
+	std::error_code repository::watch_error() const {
+		std::lock_guard lock{update_mutex_};
+		return watch_error_;
+	}
+
+	std::error_code repository::rescan(scan_stats& stats) {
+		std::pmr::vector<package> packages{};
+		std::unordered_set<std::string> names{};
+		auto const ec = directory_source{srcdir_, prefilter_}.for_each_name(
+		    [&](std::string_view name) {
+			    auto const match = match_(name);
+			    if (!match) {
+				    ++stats.name_rejections;
+				    return;
+			    }
+			    auto pkg = package::from_match(name, *match, table_);
+			    if (!pkg) {
+				    ++stats.semver_failures;
+				    return;
+			    }
+			    if (!filter_.accepts(pkg->arch)) {
+				    ++stats.arch_rejections;
+				    return;
+			    }
+			    if (!names.emplace(pkg->filename).second) return;
+
+			    ++stats.packages_kept;
+			    packages.push_back(std::move(*pkg));
+		    },
+		    stats);
+		if (ec) return ec;
+
+		// stable, to keep the directory order inside each version
+		std::stable_sort(packages.begin(), packages.end(), by_version);
+		packages_ = std::move(packages);
+		names_ = std::move(names);
+		return {};
+	}
+
+	bool repository::add(std::string_view name) {
+		if (prefilter_ && !prefilter_->accepts(name)) return false;
+		if (names_.contains(std::string{name})) return false;
+
+		auto const match = match_(name);
+		if (!match) return false;
+		auto pkg = package::from_match(name, *match, table_);
+		if (!pkg || !filter_.accepts(pkg->arch)) return false;
+
+		// newcomers go after the packages of the same version
+		names_.emplace(pkg->filename);
+		auto const pos = std::upper_bound(packages_.begin(), packages_.end(),
+		                                  *pkg, by_version);
+		packages_.insert(pos, std::move(*pkg));
+		return true;
+	}
+
+	bool repository::remove(std::string_view name) {
+		auto const it = names_.find(std::string{name});
+		if (it == names_.end()) return false;
+		names_.erase(it);
+
+		// the name may no longer read the way it did when it was taken;
+		// the package it left behind stays until the next refresh()
+		auto const match = match_(name);
+		if (!match) return false;
+		auto const pkg = package::from_match(name, *match, table_);
+		if (!pkg) return false;
+		auto const [first, last] = std::equal_range(
+		    packages_.begin(), packages_.end(), *pkg, by_version);
+		auto const pos =
+		    std::find_if(first, last, [&](package const& candidate) {
+			    return candidate.filename == name;
+		    });
+		if (pos == last) return false;
+		packages_.erase(pos);
+		return true;
+	}
+
+	void repository::publish() {
+		auto next = std::make_shared<versions>();
+		next->roots = {srcdir_};
+		next->table = table_;
+		next->packages = packages_;
+		next->build_index();
+
+		current_.store(std::move(next), std::memory_order_release);
+		generation_.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	void repository::watch([[maybe_unused]] std::stop_token stop) {
+#ifdef __linux__
+		// room for many events at once; each is a header and a padded name
+		alignas(inotify_event) std::array<char, 64 * 1024> buffer;
+		std::array<pollfd, 2> fds{{{watch_fd_, POLLIN, 0},
+		                           {wake_fd_, POLLIN, 0}}};
+
+		auto const fail = [&](std::error_code const& ec) {
+			std::lock_guard lock{update_mutex_};
+			watch_error_ = ec;
+		};
+
+		while (!stop.stop_requested()) {
+			if (::poll(fds.data(), fds.size(), -1) < 0) {
+				if (errno == EINTR) continue;
+				return fail(last_error());
+			}
+			if (fds[1].revents) return;
+
+			std::lock_guard lock{update_mutex_};
+			bool changed = false;
+			bool overflow = false;
+			bool gone = false;
+
+			// all the events queued so far go into one snapshot
+			while (true) {
+				auto const length =
+				    ::read(watch_fd_, buffer.data(), buffer.size());
+				if (length < 0) {
+					if (errno == EINTR) continue;
+					if (errno == EAGAIN) break;
+					watch_error_ = last_error();
+					if (changed) publish();
+					return;
+				}
+
+				for (size_t pos = 0; pos < static_cast<size_t>(length);) {
+					inotify_event event{};
+					std::memcpy(&event, buffer.data() + pos, sizeof(event));
+					std::string_view name{};
+					if (event.len) name = buffer.data() + pos + sizeof(event);
+					pos += sizeof(event) + event.len;
+
+					if (event.mask & IN_Q_OVERFLOW) overflow = true;
+					if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+						gone = true;
+					if (name.empty() || event.mask & IN_ISDIR) continue;
+
+					if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+						changed |= add(name);
+					else if (event.mask & (IN_DELETE | IN_MOVED_FROM))
+						changed |= remove(name);
+				}
+			}
+
+			if (overflow && !gone) {
+				scan_stats stats{};
+				if (auto const ec = rescan(stats)) {
+					watch_error_ = ec;
+					return;
+				}
+				changed = true;
+			}
+			if (changed) publish();
+			if (gone) {
+				// the last snapshot stays, as it was
+				watch_error_ =
+				    std::make_error_code(std::errc::no_such_file_or_directory);
+				return;
+			}
+		}
+#endif
+	}
+}  // namespace distro
@@ -0,0 +1,437 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "scan_index.hh"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#include "dir_scan.hh"
+#include "mapped_file.hh"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+// Layout of the index file, read in place from the mapping:
+//
+//     header
+//     record[header.count]
+//     text symbols[header.symbol_count]
+//     identifier prerelease[header.identifier_count]
+//     char strings[header.strings_size]
+//
+// Records keep the packages already parsed: the filename as a text of
+// the strings, the architecture and component as indices of the
+// symbols and both versions as numbers, with their prereleases as runs
+// of the identifiers. Loading only copies them into the packages; no
+// name is matched and no version parsed again. Matched names are
+// stored before the architecture filter, so one index serves all
+// architectures.
+
+namespace distro {
+	namespace scan_index {
+		namespace {
+			constexpr char magic[8] = {'d', 'i', 's', 't', 'r', 'o', 'i', 'x'};
+			constexpr std::uint32_t format_version = 2;
+
+			struct stamp {
+				std::uint64_t device{};
+				std::uint64_t inode{};
+				std::int64_t mtime{};
+				bool operator==(stamp const&) const = default;
+			};
+
+			struct header {
+				char magic[8];
+				std::uint32_t version;
+				std::uint32_t count;
+				std::uint64_t fingerprint;
+				stamp dir;
+				std::uint32_t symbol_count;
+				std::uint32_t identifier_count;
+				std::uint64_t strings_size;
+			};
+
+			// part of the strings
+			struct text {
+				std::uint32_t offset;
+				std::uint32_t size;
+			};
+
+			struct identifier {
+				std::uint32_t number;
+				std::uint32_t numeric;  // otherwise, the text
+				text str;
+			};
+
+			struct version_fields {
+				std::uint32_t major;
+				std::uint32_t minor;
+				std::uint32_t patch;
+				std::uint32_t prerelease;  // first identifier
+				std::uint32_t prerelease_count;
+			};
+
+			enum : std::uint32_t { has_comp = 1, has_compver = 2 };
+
+			struct record {
+				text name;
+				std::uint32_t arch;
+				std::uint32_t comp;
+				std::uint32_t flags;
+				std::uint32_t reserved;
+				version_fields version;
+				version_fields compver;
+			};
+
+			static_assert(sizeof(header) == 64);
+			static_assert(sizeof(identifier) == 16);
+			static_assert(sizeof(record) == 64);
+
+			std::optional<stamp> stamp_of(fs::path const& dir) {
+				std::error_code ec;
+				auto const mtime = fs::last_write_time(dir, ec);
+				if (ec) return std::nullopt;
+
+				stamp result{};
+				result.mtime = mtime.time_since_epoch().count();
+#ifndef _WIN32
+				struct stat st {};
+				if (::stat(dir.c_str(), &st)) return std::nullopt;
+				result.device = st.st_dev;
+				result.inode = st.st_ino;
+#endif
+				return result;
+			}
+
+			// contents of the index, gathered during the scan
+			class builder {
+			public:
+				// false, if the package does not fit the format
+				bool append(package const& pkg) {
+					static constexpr size_t max_size = 0xFFFF'FFFF;
+					if (records_.size() >= max_size) return false;
+
+					record rec{};
+					rec.arch = pkg.arch;
+					if (!add(pkg.filename, rec.name) ||
+					    !add(pkg.version, rec.version))
+						return false;
+					if (pkg.comp) {
+						rec.flags |= has_comp;
+						rec.comp = pkg.comp->name;
+						if (pkg.comp->version) {
+							rec.flags |= has_compver;
+							if (!add(*pkg.comp->version, rec.compver))
+								return false;
+						}
+					}
+					records_.push_back(rec);
+					return true;
+				}
+
+				void store(fs::path const& index_file,
+				           header head,
+				           symbol_table const& table) const;
+
+			private:
+				bool add(std::string_view str, text& result) {
+					static constexpr size_t max_size = 0xFFFF'FFFF;
+					if (strings_.size() + str.size() > max_size) return false;
+					result.offset = static_cast<std::uint32_t>(strings_.size());
+					result.size = static_cast<std::uint32_t>(str.size());
+					strings_.append(str);
+					return true;
+				}
+
+				bool add(semver const& ver, version_fields& result) {
+					static constexpr size_t max_size = 0xFFFF'FFFF;
+					// names of the archives cannot have any meta, but
+					// the index would lose it
+					if (!ver.meta.empty() ||
+					    identifiers_.size() + ver.prerelease.size() > max_size)
+						return false;
+
+					result.major = ver.major;
+					result.minor = ver.minor;
+					result.patch = ver.patch;
+					result.prerelease =
+					    static_cast<std::uint32_t>(identifiers_.size());
+					result.prerelease_count =
+					    static_cast<std::uint32_t>(ver.prerelease.size());
+					for (auto const& comp : ver.prerelease) {
+						identifier id{};
+						if (auto const* number = comp.number()) {
+							id.number = *number;
+							id.numeric = 1;
+						} else if (auto const* str = comp.text();
+						           !str || !add(*str, id.str)) {
+							return false;
+						}
+						identifiers_.push_back(id);
+					}
+					return true;
+				}
+
+				std::vector<record> records_{};
+				std::vector<identifier> identifiers_{};
+				std::string strings_{};
+			};
+
+			template <typename Item>
+			void write(std::ostream& out, std::vector<Item> const& items) {
+				out.write(reinterpret_cast<char const*>(items.data()),
+				          static_cast<std::streamsize>(items.size() *
+				                                       sizeof(Item)));
+			}
+
+			void builder::store(fs::path const& index_file,
+			                    header head,
+			                    symbol_table const& table) const {
+				auto strings = strings_;
+				std::vector<text> symbols{};
+				symbols.reserve(table.size());
+				for (symbol id = 0; id < table.size(); ++id) {
+					auto const name = table.name(id);
+					symbols.push_back(
+					    {static_cast<std::uint32_t>(strings.size()),
+					     static_cast<std::uint32_t>(name.size())});
+					strings.append(name);
+				}
+				if (strings.size() > 0xFFFF'FFFF) return;
+
+				head.count = static_cast<std::uint32_t>(records_.size());
+				head.symbol_count = static_cast<std::uint32_t>(symbols.size());
+				head.identifier_count =
+				    static_cast<std::uint32_t>(identifiers_.size());
+				head.strings_size = strings.size();
+
+				// written aside and renamed over, so that readers always see
+				// either the old or the new index
+				auto tmp = index_file;
+				tmp += ".tmp-" + std::to_string(std::random_device{}());
+
+				std::error_code ec;
+				{
+					std::ofstream out{tmp, std::ios::binary};
+					out.write(reinterpret_cast<char const*>(&head),
+					          sizeof(head));
+					write(out, records_);
+					write(out, symbols);
+					write(out, identifiers_);
+					out.write(strings.data(),
+					          static_cast<std::streamsize>(strings.size()));
+					out.flush();
+					if (!out) ec = std::make_error_code(std::errc::io_error);
+				}
+
+				if (!ec) fs::rename(tmp, index_file, ec);
+				if (ec) fs::remove(tmp, ec);
+			}
+
+			// the items of one of the arrays following the header, copied
+			// out of the mapping one at a time, as it may be unaligned
+			template <typename Item>
+			class array_view {
+			public:
+				array_view() = default;
+				array_view(char const* data, size_t size)
+				    : data_{data}, size_{size} {}
+
+				size_t size() const noexcept { return size_; }
+				Item operator[](size_t index) const noexcept {
+					Item result{};
+					std::memcpy(&result, data_ + index * sizeof(Item),
+					            sizeof(Item));
+					return result;
+				}
+
+			private:
+				char const* data_{};
+				size_t size_{};
+			};
+
+			// everything the records point at, with the bounds checked
+			struct contents {
+				std::string_view strings;
+				array_view<identifier> identifiers;
+				std::vector<symbol> symbols;
+				semver::allocator_type alloc;
+
+				std::optional<std::string_view> string(text const& str) const {
+					if (size_t{str.offset} + str.size > strings.size())
+						return std::nullopt;
+					return strings.substr(str.offset, str.size);
+				}
+
+				std::optional<semver> version(
+				    version_fields const& fields) const {
+					if (size_t{fields.prerelease} + fields.prerelease_count >
+					    identifiers.size())
+						return std::nullopt;
+
+					semver result{fields.major, fields.minor, fields.patch,
+					              alloc};
+					result.prerelease.reserve(fields.prerelease_count);
+					for (size_t index = 0; index < fields.prerelease_count;
+					     ++index) {
+						auto const id = identifiers[fields.prerelease + index];
+						if (id.numeric) {
+							result.prerelease.emplace_back(id.number);
+							continue;
+						}
+						auto const str = string(id.str);
+						if (!str) return std::nullopt;
+						result.prerelease.emplace_back(*str);
+					}
+					if (!result.prerelease.empty()) result.update_key();
+					return result;
+				}
+			};
+		}  // namespace
+
+		bool load(fs::path const& srcdir,
+		          fs::path const& index_file,
+		          StringSet const& architectures,
+		          file_matcher const& matcher,
+		          symbol_table& table,
+		          std::pmr::vector<package>& packages) {
+			auto const current = stamp_of(srcdir);
+			if (!current) return false;
+
+			mapped_file file{index_file};
+			if (!file) return false;
+			auto bytes = file.view();
+
+			header head{};
+			if (bytes.size() < sizeof(head)) return false;
+			std::memcpy(&head, bytes.data(), sizeof(head));
+			if (std::memcmp(head.magic, magic, sizeof(magic)) ||
+			    head.version != format_version ||
+			    head.fingerprint != matcher.fingerprint() ||
+			    !(head.dir == *current))
+				return false;
+			bytes.remove_prefix(sizeof(head));
+
+			auto const records_size = size_t{head.count} * sizeof(record);
+			auto const symbols_size = size_t{head.symbol_count} * sizeof(text);
+			auto const identifiers_size =
+			    size_t{head.identifier_count} * sizeof(identifier);
+			if (bytes.size() < records_size + symbols_size + identifiers_size ||
+			    bytes.size() - records_size - symbols_size - identifiers_size !=
+			        head.strings_size)
+				return false;
+
+			array_view<record> const records{bytes.data(), head.count};
+			array_view<text> const symbol_names{bytes.data() + records_size,
+			                                    head.symbol_count};
+			contents index{
+			    bytes.substr(records_size + symbols_size + identifiers_size),
+			    {bytes.data() + records_size + symbols_size,
+			     head.identifier_count},
+			    {},
+			    packages.get_allocator()};
+
+			// the symbols of the scan, which built the index, each interned
+			// once
+			index.symbols.reserve(head.symbol_count);
+			for (size_t id = 0; id < symbol_names.size(); ++id) {
+				auto const name = index.string(symbol_names[id]);
+				if (!name) return false;
+				index.symbols.push_back(table.intern(*name));
+			}
+			auto const symbol_of = [&](std::uint32_t id) {
+				return id < index.symbols.size()
+				           ? std::optional{index.symbols[id]}
+				           : std::nullopt;
+			};
+
+			arch_filter const filter{architectures, table};
+			std::pmr::vector<package> result{packages.get_allocator()};
+			result.reserve(head.count);
+			for (size_t index_pos = 0; index_pos < records.size();
+			     ++index_pos) {
+				auto const rec = records[index_pos];
+				auto const arch = symbol_of(rec.arch);
+				if (!arch) return false;
+				if (!filter.accepts(*arch)) continue;
+
+				auto const name = index.string(rec.name);
+				auto version = index.version(rec.version);
+				if (!name || !version) return false;
+
+				auto& pkg = result.emplace_back();
+				pkg.filename = *name;
+				pkg.version = std::move(*version);
+				pkg.arch = *arch;
+				if (rec.flags & has_comp) {
+					auto const comp = symbol_of(rec.comp);
+					if (!comp) return false;
+					pkg.comp = package::component{*comp, std::nullopt};
+					if (rec.flags & has_compver) {
+						auto compver = index.version(rec.compver);
+						if (!compver) return false;
+						pkg.comp->version = std::move(*compver);
+					}
+				}
+			}
+
+			packages = std::move(result);
+			return true;
+		}
+
+		std::error_code rebuild(fs::path const& srcdir,
+		                        fs::path const& index_file,
+		                        StringSet const& architectures,
+		                        file_matcher const& matcher,
+		                        symbol_table& table,
+		                        std::pmr::vector<package>& packages) {
+			auto const started = fs::file_time_type::clock::now();
+			auto const before = stamp_of(srcdir);
+
+			arch_filter const filter{architectures, table};
+			builder index{};
+			bool storable = true;
+
+			auto const ec = for_each_file(
+			    srcdir, [&](std::string_view name) {
+				    auto match = matcher.match(name);
+				    if (!match) return;
+				    auto pkg = package::from_match(name, *match, table,
+				                                   packages.get_allocator());
+				    if (!pkg) return;
+
+				    if (storable) storable = index.append(*pkg);
+
+				    if (!filter.accepts(pkg->arch)) return;
+
+				    packages.push_back(std::move(*pkg));
+			    });
+			if (ec) return ec;
+
+			// a file added within the same tick of the filesystem clock as
+			// the last change would not move the mtime, so only directories
+			// which settled down before the scan are worth an index
+			static constexpr auto settle_time = std::chrono::seconds{2};
+			auto const after = stamp_of(srcdir);
+			if (!storable || !before || !after || !(*before == *after))
+				return {};
+			auto const mtime = fs::file_time_type{
+			    fs::file_time_type::duration{before->mtime}};
+			if (mtime + settle_time > started) return {};
+
+			header head{};
+			std::memcpy(head.magic, magic, sizeof(magic));
+			head.version = format_version;
+			head.fingerprint = matcher.fingerprint();
+			head.dir = *before;
+			index.store(index_file, head, table);
+
+			return {};
+		}
+	}  // namespace scan_index
+}  // namespace distro
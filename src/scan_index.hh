@@ -0,0 +1,31 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <distro/versions.hh>
+
+namespace distro {
+	namespace scan_index {
+		// fills the packages from the index file, if it was built for the
+		// same directory, unchanged since, with the same matcher; returns
+		// false for missing, stale or damaged indices; names of the
+		// architectures and components are interned into the table
+		bool load(fs::path const& srcdir,
+		          fs::path const& index_file,
+		          StringSet const& architectures,
+		          file_matcher const& matcher,
+		          symbol_table& table,
+		          std::pmr::vector<package>& packages);
+
+		// scans the directory, filling the packages and replacing the index
+		// file, if the directory did not change while being scanned
+		std::error_code rebuild(fs::path const& srcdir,
+		                        fs::path const& index_file,
+		                        StringSet const& architectures,
+		                        file_matcher const& matcher,
+		                        symbol_table& table,
+		                        std::pmr::vector<package>& packages);
+	}  // namespace scan_index
+}  // namespace distro
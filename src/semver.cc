@@ -6,31 +6,99 @@
 
 #include <algorithm>
 #include <charconv>
-#include <iterator>
-
-#include <distro/regex.hh>
+#include <cstring>
+#include <limits>
+#include <string_view>
 
 namespace distro {
-	static auto const semvercomp_pattern = std::regex{
-	    "^0|[1-9]\\d*$", std::regex::ECMAScript | std::regex::optimize};
-	static auto const semver_pattern = std::regex{
-	    "^(0|[1-9]\\d*)\\.(0|[1-9]\\d*)\\.(0|[1-9]\\d*)(?:-((?:0|[1-9]\\d*|\\d*"
-	    "[a-"
-	    "zA-Z-][0-9a-zA-Z-]*)(?:\\.(?:0|[1-9]\\d*|\\d*[a-zA-Z-][0-9a-zA-Z-]*))*"
-	    "))?("
-	    "?:\\+([0-9a-zA-Z-]+(?:\\.[0-9a-zA-Z-]+)*))?$",
-	    std::regex::ECMAScript | std::regex::optimize};
-
-	inline unsigned to_unsigned(std::string_view in) {
-		unsigned result{};
-		(void)std::from_chars(in.data(), in.data() + in.size(), result);
-		return result;
+	namespace {
+		constexpr bool is_digit(char c) noexcept {
+			return c >= '0' && c <= '9';
+		}
+
+		constexpr bool is_identifier(char c) noexcept {
+			return is_digit(c) || (c >= 'a' && c <= 'z') ||
+			       (c >= 'A' && c <= 'Z') || c == '-';
+		}
+
+		inline unsigned to_unsigned(std::string_view in) {
+			unsigned result{};
+			(void)std::from_chars(in.data(), in.data() + in.size(), result);
+			return result;
+		}
+
+		// (0|[1-9][0-9]*), stops on first non-digit
+		bool read_number(std::string_view view, size_t& pos, unsigned& result) {
+			auto const start = pos;
+			while (pos < view.size() && is_digit(view[pos]))
+				++pos;
+			if (pos == start) return false;
+			if (view[start] == '0' && (pos - start) > 1) return false;
+			result = to_unsigned(view.substr(start, pos - start));
+			return true;
+		}
+
+		// [0-9a-zA-Z-]+, stops on first non-identifier character; as with
+		// numbers, identifiers starting with '0' must be exactly "0"
+		bool read_identifier(std::string_view view,
+		                     size_t& pos,
+		                     std::string_view& ident,
+		                     bool& numeric) {
+			auto const start = pos;
+			numeric = true;
+			while (pos < view.size() && is_identifier(view[pos])) {
+				if (!is_digit(view[pos])) numeric = false;
+				++pos;
+			}
+			if (pos == start) return false;
+			if (view[start] == '0' && (pos - start) > 1) return false;
+			ident = view.substr(start, pos - start);
+			return true;
+		}
+
+		bool skip(std::string_view view, size_t& pos, char c) {
+			if (pos >= view.size() || view[pos] != c) return false;
+			++pos;
+			return true;
+		}
+
+		// each part of a packed release takes 21 bits
+		constexpr bool fits_release(unsigned major,
+		                            unsigned minor,
+		                            unsigned patch) noexcept {
+			constexpr unsigned limit = 1u << 21;
+			return major < limit && minor < limit && patch < limit;
+		}
+
+		// stable versions sort after the prereleases of the same numbers
+		constexpr std::uint64_t release_of(unsigned major,
+		                                   unsigned minor,
+		                                   unsigned patch,
+		                                   bool stable) noexcept {
+			return (std::uint64_t{major} << 43) |
+			       (std::uint64_t{minor} << 22) |
+			       (std::uint64_t{patch} << 1) | (stable ? 1u : 0u);
+		}
+	}  // namespace
+
+	semver::comp::comp(comp const& other, allocator_type const& alloc) {
+		if (auto const* text = std::get_if<std::pmr::string>(&other.value))
+			value.emplace<std::pmr::string>(*text, alloc);
+		else
+			value = other.value;
+	}
+
+	semver::comp::comp(comp&& other, allocator_type const& alloc) {
+		if (auto* text = std::get_if<std::pmr::string>(&other.value))
+			value.emplace<std::pmr::string>(std::move(*text), alloc);
+		else
+			value = other.value;
 	}
 
 	std::string semver::comp::to_string() const {
 		if (std::holds_alternative<unsigned>(value))
 			return std::to_string(std::get<unsigned>(value));
-		return std::get<std::string>(value);
+		return std::string{std::get<std::pmr::string>(value)};
 	}
 
 	bool semver::comp::operator<(comp const& rhs) const {
@@ -44,19 +112,54 @@ namespace distro {
 		if (std::holds_alternative<unsigned>(rhs.value))
 			return false;  // strings > numbers
 
-		return std::get<std::string>(value) < std::get<std::string>(rhs.value);
+		return std::get<std::pmr::string>(value) <
+		       std::get<std::pmr::string>(rhs.value);
 	}
 
 	bool semver::comp::operator==(comp const& rhs) const {
 		return value == rhs.value;
 	}
 
-	semver::comp semver::comp::from_string(std::string_view view) {
-		if (std::regex_match(view.begin(), view.end(), semvercomp_pattern))
-			return to_unsigned(view);
-		return std::string{view.data(), view.size()};
+	semver::comp semver::comp::from_string(std::string_view view,
+	                                       allocator_type const& alloc) {
+		auto const numeric =
+		    !view.empty() && (view.front() != '0' || view.size() == 1) &&
+		    std::all_of(view.begin(), view.end(), is_digit);
+		if (numeric) return {to_unsigned(view), alloc};
+		return {view, alloc};
+	}
+
+	semver::semver(allocator_type const& alloc)
+	    : prerelease{alloc}, meta{alloc} {}
+
+	semver::semver(unsigned major,
+	               unsigned minor,
+	               unsigned patch,
+	               allocator_type const& alloc)
+	    : major{major}
+	    , minor{minor}
+	    , patch{patch}
+	    , prerelease{alloc}
+	    , meta{alloc} {
+		update_key();
 	}
 
+	semver::semver(semver const& other, allocator_type const& alloc)
+	    : major{other.major}
+	    , minor{other.minor}
+	    , patch{other.patch}
+	    , prerelease{other.prerelease, alloc}
+	    , meta{other.meta, alloc}
+	    , key{other.key} {}
+
+	semver::semver(semver&& other, allocator_type const& alloc)
+	    : major{other.major}
+	    , minor{other.minor}
+	    , patch{other.patch}
+	    , prerelease{std::move(other.prerelease), alloc}
+	    , meta{std::move(other.meta), alloc}
+	    , key{other.key} {}
+
 	std::string semver::to_string() const {
 		auto result = std::to_string(major);
 		result.push_back('.');
@@ -81,9 +184,90 @@ namespace distro {
 	}
 
 	bool semver::operator<(semver const& rhs) const {
-		if (major != rhs.major) return major < rhs.major;
-		if (minor != rhs.minor) return minor < rhs.minor;
-		if (patch != rhs.patch) return patch < rhs.patch;
+		return compare(rhs) < 0;
+	}
+
+	bool semver::operator==(semver const& rhs) const {
+		return compare(rhs) == 0;
+	}
+
+	bool semver::key_matches() const noexcept {
+		if (!key.packed() || key.identifiers_ != prerelease.size() ||
+		    !fits_release(major, minor, patch))
+			return false;
+		return key.release_ ==
+		       release_of(major, minor, patch, prerelease.empty());
+	}
+
+	void semver::update_key() {
+		key = sort_key{};
+		if (!fits_release(major, minor, patch) ||
+		    prerelease.size() > std::numeric_limits<std::uint8_t>::max())
+			return;
+
+		key.release_ = release_of(major, minor, patch, prerelease.empty());
+		key.identifiers_ = static_cast<std::uint8_t>(prerelease.size());
+		key.flags_ = sort_key::packed_flag;
+		if (prerelease.empty()) return;
+
+		auto& buffer = key.prerelease_;
+		size_t length = 0;
+		bool truncated = false;
+		auto const put = [&](std::uint8_t byte) {
+			if (length < buffer.size())
+				buffer[length++] = byte;
+			else
+				truncated = true;
+		};
+
+		for (auto const& item : prerelease) {
+			if (auto const* number = std::get_if<unsigned>(&item.value)) {
+				put(0x01);
+				for (auto byte = sizeof(unsigned); byte > 0; --byte)
+					put(static_cast<std::uint8_t>(*number >> ((byte - 1) * 8)));
+			} else {
+				auto const& text = std::get<std::pmr::string>(item.value);
+				// NUL would be mistaken for the end of the string
+				if (text.find('\0') != std::pmr::string::npos) {
+					key = sort_key{};
+					return;
+				}
+				put(0x02);
+				for (auto c : text)
+					put(static_cast<std::uint8_t>(c));
+				put(0x00);
+			}
+			if (truncated) break;
+		}
+		put(0xFF);
+
+		key.length_ = static_cast<std::uint8_t>(length);
+		if (truncated) key.flags_ |= sort_key::truncated_flag;
+	}
+
+	int semver::compare(semver const& rhs) const {
+		if (key_matches() && rhs.key_matches()) {
+			if (key.release_ != rhs.key.release_)
+				return key.release_ < rhs.key.release_ ? -1 : 1;
+
+			auto const length = std::min(key.length_, rhs.key.length_);
+			if (auto const diff = std::memcmp(key.prerelease_.data(),
+			                                  rhs.key.prerelease_.data(),
+			                                  length))
+				return diff;
+
+			// no complete encoding is a prefix of another one, so with the
+			// bytes equal, full keys describe the same prerelease
+			if (!key.truncated() && !rhs.key.truncated()) return 0;
+		}
+
+		return compare_fields(rhs);
+	}
+
+	int semver::compare_fields(semver const& rhs) const {
+		if (major != rhs.major) return major < rhs.major ? -1 : 1;
+		if (minor != rhs.minor) return minor < rhs.minor ? -1 : 1;
+		if (patch != rhs.patch) return patch < rhs.patch ? -1 : 1;
 
 		auto const lhsLen = prerelease.size();
 		auto const rhsLen = rhs.prerelease.size();
@@ -92,96 +276,47 @@ namespace distro {
 		for (size_t index = 0; index < minlen; ++index) {
 			auto const& lhsItem = prerelease.at(index);
 			auto const& rhsItem = rhs.prerelease.at(index);
-			if (lhsItem < rhsItem) return true;
-			if (rhsItem < lhsItem) return false;
+			if (lhsItem < rhsItem) return -1;
+			if (rhsItem < lhsItem) return 1;
 			// continue...
 		}
 		// the one with shorter prerelease is greater...
-		return rhsLen < lhsLen;
+		if (lhsLen == rhsLen) return 0;
+		return rhsLen < lhsLen ? -1 : 1;
 	}
 
-	bool semver::operator==(semver const& rhs) const {
-		if ((major != rhs.major) || (minor != rhs.minor) ||
-		    (patch != rhs.patch) ||
-		    (prerelease.size() != rhs.prerelease.size()))
-			return false;
+	std::optional<semver> semver::from_string(std::string_view view,
+	                                          allocator_type const& alloc) {
+		semver result{alloc};
+		size_t pos = 0;
+		if (!read_number(view, pos, result.major) || !skip(view, pos, '.') ||
+		    !read_number(view, pos, result.minor) || !skip(view, pos, '.') ||
+		    !read_number(view, pos, result.patch))
+			return std::nullopt;
 
-		auto lhsIt = prerelease.begin();
-		auto rhsIt = rhs.prerelease.begin();
-		auto end = prerelease.end();
-		for (; lhsIt != end; ++lhsIt, ++rhsIt) {
-			auto const& lhsItem = *lhsIt;
-			auto const& rhsItem = *rhsIt;
-			if (!(lhsItem == rhsItem)) return false;
+		std::string_view ident{};
+		bool numeric{};
+		if (skip(view, pos, '-')) {
+			do {
+				if (!read_identifier(view, pos, ident, numeric))
+					return std::nullopt;
+				if (numeric)
+					result.prerelease.emplace_back(to_unsigned(ident));
+				else
+					result.prerelease.emplace_back(ident);
+			} while (skip(view, pos, '.'));
 		}
-		return true;
-	}
 
-	template <typename Capture>
-	std::optional<std::vector<std::string>> splitIdentifiers(
-	    Capture const& capture) {
-		if (!capture.matched) {
-			// valid identifier state -- missing...
-			return std::vector<std::string>{};
-		}
-		auto chunks = to_view(capture);
-		size_t prev = 0, curr = 0, end = chunks.size();
-		std::optional<std::vector<std::string>> result{
-		    std::vector<std::string>{}};
-
-		while (curr != end) {
-			auto const c = static_cast<unsigned char>(chunks[curr]);
-			if (c == '.') {
-				if (prev == curr)  // empty chunk
+		if (skip(view, pos, '+')) {
+			do {
+				if (!read_identifier(view, pos, ident, numeric))
 					return std::nullopt;
-				if (chunks[prev] == '0' && (curr - prev) > 1)
-					return std::nullopt;
-
-				result->emplace_back(chunks.data() + prev,
-				                     chunks.data() + curr);
-				++curr;
-				prev = curr;
-				continue;
-			}
-
-			if (!std::isalnum(c) && c != '-') return std::nullopt;
-			++curr;
+				result.meta.emplace_back(ident);
+			} while (skip(view, pos, '.'));
 		}
-		if (prev == curr)  // empty chunk
-			return std::nullopt;
-		if (chunks[prev] == '0' && (curr - prev) > 1) return std::nullopt;
 
-		result->emplace_back(chunks.data() + prev, chunks.data() + curr);
+		if (pos != view.size()) return std::nullopt;
+		result.update_key();
 		return result;
 	}
-
-	std::optional<semver> semver::from_string(std::string_view view) {
-		svmatch match{};
-		if (std::regex_match(view.begin(), view.end(), match, semver_pattern)) {
-			auto& major = match[1];
-			auto& minor = match[2];
-			auto& patch = match[3];
-			auto& prerelease = match[4];
-			auto& meta = match[5];
-
-			auto prerel_strings = splitIdentifiers(prerelease);
-			auto meta_strings = splitIdentifiers(meta);
-
-			if (prerel_strings && meta_strings) {
-				std::vector<comp> comps;
-				comps.reserve(prerel_strings->size());
-
-				std::transform(prerel_strings->begin(), prerel_strings->end(),
-				               std::back_inserter(comps), [](auto const& str) {
-					               return comp::from_string(str);
-				               });
-
-				return semver{to_unsigned(to_view(major)),
-				              to_unsigned(to_view(minor)),
-				              to_unsigned(to_view(patch)), std::move(comps),
-				              std::move(*meta_strings)};
-			}
-		}
-		return std::nullopt;
-	}
 }  // namespace distro
@@ -0,0 +1,96 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/symbols.hh>
+
+#include <algorithm>
+
+namespace distro {
+	namespace {
+		// past that many names, the linear search loses to hashing
+		constexpr size_t linear_limit = 16;
+	}  // namespace
+
+	symbol_table::symbol_table(symbol_table const& other)
+	    : names_{other.names_} {
+		rebuild_index();
+	}
+
+	symbol_table& symbol_table::operator=(symbol_table const& other) {
+		if (this != &other) {
+			names_ = other.names_;
+			rebuild_index();
+		}
+		return *this;
+	}
+
+	symbol symbol_table::intern(std::string_view name) {
+		if (auto const id = find(name)) return *id;
+
+		auto const id = static_cast<symbol>(names_.size());
+		names_.emplace_back(name);
+		if (!index_.empty())
+			index_.emplace(names_.back(), id);
+		else if (names_.size() > linear_limit)
+			rebuild_index();
+		return id;
+	}
+
+	std::optional<symbol> symbol_table::find(
+	    std::string_view name) const noexcept {
+		if (!index_.empty()) {
+			auto const it = index_.find(name);
+			if (it == index_.end()) return std::nullopt;
+			return it->second;
+		}
+
+		auto const it = std::find(names_.begin(), names_.end(), name);
+		if (it == names_.end()) return std::nullopt;
+		return static_cast<symbol>(it - names_.begin());
+	}
+
+	void symbol_table::rebuild_index() {
+		index_.clear();
+		if (names_.size() <= linear_limit) return;
+		index_.reserve(names_.size());
+		symbol id{};
+		for (auto const& name : names_)
+			index_.emplace(name, id++);
+	}
+
+	void symbol_set::insert(symbol id) {
+		auto const word = id / bits;
+		if (word >= words_.size()) words_.resize(word + 1);
+		auto const mask = std::uint64_t{1} << (id % bits);
+		if (words_[word] & mask) return;
+		words_[word] |= mask;
+		++count_;
+	}
+
+	void symbol_set::erase(symbol id) noexcept {
+		auto const word = id / bits;
+		if (word >= words_.size()) return;
+		auto const mask = std::uint64_t{1} << (id % bits);
+		if (!(words_[word] & mask)) return;
+		words_[word] &= ~mask;
+		--count_;
+	}
+
+	arch_filter::arch_filter(StringSet const& architectures,
+	                         symbol_table& table,
+	                         allocator_type const& alloc)
+	    : any_{architectures.empty()}, allowed_{alloc} {
+		for (auto const& arch : architectures)
+			allowed_.insert(table.intern(arch));
+	}
+
+	arch_filter::arch_filter(StringSet const& architectures,
+	                         symbol_table const& table,
+	                         allocator_type const& alloc)
+	    : any_{architectures.empty()}, allowed_{alloc} {
+		for (auto const& arch : architectures) {
+			if (auto const id = table.find(arch)) allowed_.insert(*id);
+		}
+	}
+}  // namespace distro
@@ -0,0 +1,326 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "archive.hh"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace distro {
+	namespace archive {
+		using namespace std::literals;
+
+		namespace {
+			constexpr size_t block_size = 512;
+			using block = std::array<char, block_size>;
+
+			std::error_code damaged() {
+				return make_error_code(extract_errc::damaged_archive);
+			}
+
+			std::string_view field(block const& header,
+			                       size_t offset,
+			                       size_t length) {
+				std::string_view const view{header.data() + offset, length};
+				return view.substr(0, view.find('\0'));
+			}
+
+			// octal, padded with spaces or NULs, or big-endian base-256
+			// with the highest bit of the first byte set, as GNU tar
+			// writes the sizes not fitting into eleven octal digits
+			std::optional<std::uint64_t> number(block const& header,
+			                                    size_t offset,
+			                                    size_t length) {
+				std::string_view view{header.data() + offset, length};
+				std::uint64_t result{};
+
+				if (static_cast<unsigned char>(view.front()) & 0x80) {
+					view.remove_prefix(1);
+					for (auto c : view) {
+						if (result >> 56) return std::nullopt;
+						result = (result << 8) | static_cast<unsigned char>(c);
+					}
+					return result;
+				}
+
+				auto pos = view.find_first_not_of(" \0"sv);
+				if (pos == std::string_view::npos) return result;
+				for (; pos < view.size(); ++pos) {
+					auto const c = view[pos];
+					if (c == ' ' || c == '\0') break;
+					if (c < '0' || c > '7' || result >> 61) return std::nullopt;
+					result = result * 8 + static_cast<unsigned>(c - '0');
+				}
+				return result;
+			}
+
+			bool is_zero(block const& header) {
+				return std::all_of(header.begin(), header.end(),
+				                   [](char c) { return c == '\0'; });
+			}
+
+			// the checksum field counts as spaces; some old tars summed
+			// signed chars
+			bool valid_checksum(block const& header) {
+				auto const stored = number(header, 148, 8);
+				if (!stored) return false;
+
+				std::uint64_t unsigned_sum{};
+				std::int64_t signed_sum{};
+				for (size_t index = 0; index < header.size(); ++index) {
+					auto const c = index >= 148 && index < 156 ? ' '
+					                                           : header[index];
+					unsigned_sum += static_cast<unsigned char>(c);
+					signed_sum += static_cast<signed char>(c);
+				}
+				return *stored == unsigned_sum ||
+				       static_cast<std::int64_t>(*stored) == signed_sum;
+			}
+
+			class tar_reader {
+			public:
+				tar_reader(byte_source& source, entry_sink& sink)
+				    : source_{source}, sink_{sink} {}
+
+				std::error_code read();
+
+			private:
+				// contents of an entry, given size bytes at a time, with
+				// the padding up to the next block skipped
+				template <typename Consumer>
+				std::error_code read_data(std::uint64_t size,
+				                          Consumer&& consume);
+				std::error_code read_text(std::uint64_t size,
+				                          std::string& text);
+				std::error_code skip(std::uint64_t size) {
+					return read_data(size,
+					                 [](std::string_view) -> std::error_code {
+						                 return {};
+					                 });
+				}
+				void read_pax(std::string_view records);
+
+				std::error_code entry(block const& header);
+
+				byte_source& source_;
+				entry_sink& sink_;
+				std::vector<char> buffer_ = std::vector<char>(64 * 1024);
+
+				// overrides of the next entry, from GNU long name entries
+				// and pax extended headers
+				std::optional<std::string> path_{};
+				std::optional<std::string> link_{};
+				std::optional<std::uint64_t> size_{};
+			};
+
+			std::error_code tar_reader::read() {
+				block header{};
+				bool first = true;
+				while (true) {
+					size_t count{};
+					if (auto ec = source_.read(header, count)) return ec;
+
+					// anything too short for a header, or failing its
+					// checksum, is not a tar at all, if it comes first
+					bool const complete = count == header.size();
+					if (complete && is_zero(header)) break;
+					if (first && (!complete || !valid_checksum(header)))
+						return make_error_code(extract_errc::unknown_format);
+					// a missing end-of-archive marker is forgiven
+					if (!count) break;
+					if (!complete || !valid_checksum(header)) return damaged();
+					first = false;
+
+					if (auto ec = entry(header)) return ec;
+				}
+				return {};
+			}
+
+			template <typename Consumer>
+			std::error_code tar_reader::read_data(std::uint64_t size,
+			                                      Consumer&& consume) {
+				auto const padded =
+				    (size + block_size - 1) / block_size * block_size;
+				for (std::uint64_t left = padded; left;) {
+					auto const chunk = static_cast<size_t>(
+					    std::min(left, std::uint64_t{buffer_.size()}));
+					size_t count{};
+					if (auto ec = source_.read({buffer_.data(), chunk}, count))
+						return ec;
+					if (count != chunk) return damaged();
+
+					auto const offset = padded - left;
+					if (offset < size) {
+						auto const used = static_cast<size_t>(
+						    std::min(std::uint64_t{chunk}, size - offset));
+						if (auto ec = consume({buffer_.data(), used}))
+							return ec;
+					}
+					left -= chunk;
+				}
+				return {};
+			}
+
+			std::error_code tar_reader::read_text(std::uint64_t size,
+			                                      std::string& text) {
+				// names and pax headers are short, anything else is not
+				// a tar made by a sane tool
+				if (size > 1024 * 1024) return damaged();
+				text.clear();
+				return read_data(size, [&](std::string_view chunk) {
+					text.append(chunk);
+					return std::error_code{};
+				});
+			}
+
+			// "<length> <key>=<value>\n" records
+			void tar_reader::read_pax(std::string_view records) {
+				while (!records.empty()) {
+					size_t length{};
+					size_t pos = 0;
+					while (pos < records.size() && records[pos] >= '0' &&
+					       records[pos] <= '9') {
+						length = length * 10 +
+						         static_cast<size_t>(records[pos] - '0');
+						++pos;
+					}
+					if (!length || length > records.size() ||
+					    pos >= length || records[pos] != ' ')
+						return;
+
+					auto record = records.substr(pos + 1, length - pos - 1);
+					records.remove_prefix(length);
+					if (!record.empty() && record.back() == '\n')
+						record.remove_suffix(1);
+
+					auto const eq = record.find('=');
+					if (eq == std::string_view::npos) continue;
+					auto const key = record.substr(0, eq);
+					auto const value = record.substr(eq + 1);
+
+					if (key == "path"sv) {
+						path_ = std::string{value};
+					} else if (key == "linkpath"sv) {
+						link_ = std::string{value};
+					} else if (key == "size"sv) {
+						std::uint64_t size{};
+						for (auto c : value) {
+							if (c < '0' || c > '9') return;
+							size = size * 10 + static_cast<unsigned>(c - '0');
+						}
+						size_ = size;
+					}
+				}
+			}
+
+			std::error_code tar_reader::entry(block const& header) {
+				auto const type = header[156];
+				auto const header_size = number(header, 124, 12);
+				if (!header_size) return damaged();
+				auto const size = size_ ? *size_ : *header_size;
+
+				switch (type) {
+					case 'L':
+					case 'K': {
+						std::string text{};
+						if (auto ec = read_text(size, text)) return ec;
+						text.erase(std::find(text.begin(), text.end(), '\0'),
+						           text.end());
+						(type == 'L' ? path_ : link_) = std::move(text);
+						size_.reset();
+						return {};
+					}
+					case 'x': {
+						std::string text{};
+						if (auto ec = read_text(size, text)) return ec;
+						size_.reset();
+						read_pax(text);
+						return {};
+					}
+					case 'g':
+						size_.reset();
+						return skip(size);
+					default:
+						break;
+				}
+
+				std::string name{};
+				if (path_) {
+					name = std::move(*path_);
+				} else {
+					name = field(header, 0, 100);
+					// POSIX ustar only, GNU tar keeps other data there
+					auto const ustar =
+					    std::string_view{header.data() + 257, 6} == "ustar\0"sv;
+					auto const prefix =
+					    ustar ? field(header, 345, 155) : std::string_view{};
+					if (!prefix.empty())
+						name = std::string{prefix} + '/' + name;
+				}
+				auto link = link_ ? std::move(*link_)
+				                  : std::string{field(header, 157, 100)};
+				path_.reset();
+				link_.reset();
+				size_.reset();
+
+				std::error_code ec{};
+				auto const path = safe_path(name, ec);
+				if (ec) return ec;
+				// the root itself and the devices are left alone
+				if (path.empty()) return skip(size);
+
+				auto const mode = static_cast<std::uint32_t>(
+				    number(header, 100, 8).value_or(0) & 07777);
+
+				switch (type) {
+					case '\0':
+					case '0':
+					case '7':
+						// pre-POSIX tars marked directories by the slash
+						if (name.back() == '/') {
+							if (auto err = sink_.directory(path)) return err;
+							return skip(size);
+						}
+						if (auto err = sink_.file_begin(path, mode))
+							return err;
+						if (auto err = read_data(size,
+						                         [&](std::string_view chunk) {
+							                         return sink_.file_data(
+							                             chunk);
+						                         }))
+							return err;
+						return sink_.file_end();
+					case '1': {
+						auto const target = safe_path(link, ec);
+						if (ec) return ec;
+						if (auto err = sink_.hardlink(path, target))
+							return err;
+						return skip(size);
+					}
+					case '2':
+						if (!safe_link(path, link))
+							return make_error_code(extract_errc::unsafe_path);
+						if (auto err = sink_.symlink(path, link)) return err;
+						return skip(size);
+					case '5':
+						if (auto err = sink_.directory(path)) return err;
+						return skip(size);
+					case 'S':
+					case 'M':
+						// sparse and multi-volume files
+						return make_error_code(
+						    extract_errc::unsupported_entry);
+					default:
+						return skip(size);
+				}
+			}
+		}  // namespace
+
+		std::error_code read_tar(byte_source& source, entry_sink& sink) {
+			return tar_reader{source, sink}.read();
+		}
+	}  // namespace archive
+}  // namespace distro
@@ -0,0 +1,240 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/version_constraint.hh>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+
+namespace distro {
+	namespace {
+		semver make(unsigned major, unsigned minor, unsigned patch) {
+			return {major, minor, patch};
+		}
+
+		std::array<unsigned, 3> numbers_of(semver const& version) {
+			return {version.major, version.minor, version.patch};
+		}
+
+		// bound lying below X.Y.Z and all of its prereleases
+		version_constraint::bound lowest_of(
+		    semver const& version,
+		    semver::allocator_type const& alloc = {}) {
+			return {{version.major, version.minor, version.patch, alloc},
+			        false,
+			        true};
+		}
+
+		// the position of one bound against the other, as bound::compare
+		// gives it for versions
+		int compare(version_constraint::bound const& lhs,
+		            version_constraint::bound const& rhs) {
+			if (!lhs.before_prereleases) return rhs.compare(lhs.version);
+			if (!rhs.before_prereleases) return -lhs.compare(rhs.version);
+			auto const lhs_numbers = numbers_of(lhs.version);
+			auto const rhs_numbers = numbers_of(rhs.version);
+			if (lhs_numbers == rhs_numbers) return 0;
+			return lhs_numbers < rhs_numbers ? -1 : 1;
+		}
+
+		struct partial {
+			semver version;
+			// how many of major, minor and patch were given
+			unsigned parts;
+		};
+
+		bool is_wildcard(std::string_view part) {
+			return part == "x" || part == "X" || part == "*";
+		}
+
+		// full semver, or up to three dot-separated numbers, where the
+		// first wildcard ends the version
+		std::optional<partial> read_partial(std::string_view view) {
+			if (auto full = semver::from_string(view)) return partial{*full, 3};
+
+			unsigned parts[3] = {};
+			unsigned count = 0;
+			while (count < 3) {
+				auto const dot = view.find('.');
+				auto const part = view.substr(0, dot);
+				if (is_wildcard(part)) break;
+
+				auto const* end = part.data() + part.size();
+				auto const [ptr, ec] =
+				    std::from_chars(part.data(), end, parts[count]);
+				if (ec != std::errc{} || ptr != end) return std::nullopt;
+				++count;
+
+				if (dot == std::string_view::npos) {
+					view = {};
+					break;
+				}
+				view = view.substr(dot + 1);
+			}
+			// a wildcard may only be followed by more wildcards
+			while (!view.empty()) {
+				auto const dot = view.find('.');
+				if (!is_wildcard(view.substr(0, dot))) return std::nullopt;
+				view = dot == std::string_view::npos ? std::string_view{}
+				                                     : view.substr(dot + 1);
+			}
+
+			return partial{make(parts[0], parts[1], parts[2]), count};
+		}
+
+		// first version past everything starting with the given parts
+		semver next_after(partial const& ver) {
+			auto const& v = ver.version;
+			if (ver.parts < 2) return make(v.major + 1, 0, 0);
+			if (ver.parts < 3) return make(v.major, v.minor + 1, 0);
+			return make(v.major, v.minor, v.patch + 1);
+		}
+	}  // namespace
+
+	version_constraint version_constraint::exact(
+	    semver const& version,
+	    semver::allocator_type const& alloc) {
+		version_constraint result{};
+		if (version.prerelease.empty())
+			result.lower_ = lowest_of(version, alloc);
+		else
+			result.lower_ = bound{semver{version, alloc}, true};
+		result.upper_ = bound{semver{version, alloc}, true};
+		return result;
+	}
+
+	version_constraint version_constraint::newest_stable() {
+		version_constraint result{};
+		result.stable_only_ = true;
+		return result;
+	}
+
+	std::optional<version_constraint> version_constraint::from_string(
+	    std::string_view view) {
+		static constexpr std::string_view spaces = " \t";
+
+		version_constraint result{};
+		while (true) {
+			auto const start = view.find_first_not_of(spaces);
+			if (start == std::string_view::npos) break;
+			view = view.substr(start);
+
+			auto const end = view.find_first_of(spaces);
+			if (!result.add_term(view.substr(0, end))) return std::nullopt;
+			if (end == std::string_view::npos) break;
+			view = view.substr(end);
+		}
+		return result;
+	}
+
+	bool version_constraint::add_term(std::string_view term) {
+		if (term == "stable") {
+			stable_only_ = true;
+			return true;
+		}
+		if (is_wildcard(term)) return true;
+
+		std::string_view op{};
+		for (std::string_view known : {">=", "<=", ">", "<", "=", "^", "~"}) {
+			if (term.starts_with(known)) {
+				op = known;
+				break;
+			}
+		}
+
+		auto const ver = read_partial(term.substr(op.size()));
+		if (!ver) return false;
+		auto const& [version, parts] = *ver;
+
+		// a partial version starts below the prereleases of its first
+		// release, same as the partial upper bounds end
+		auto const from =
+		    parts == 3 ? bound{version, true} : lowest_of(version);
+
+		if (op.empty() || op == "=") {
+			if (parts == 3) {
+				auto const single = exact(version);
+				narrow_lower(bound{*single.lower_});
+				narrow_upper(bound{*single.upper_});
+			} else {
+				narrow_lower(bound{from});
+				narrow_upper(lowest_of(next_after(*ver)));
+			}
+		} else if (op == "^") {
+			narrow_lower(bound{from});
+			auto const first_non_zero = version.major || parts < 2   ? 1u
+			                            : version.minor || parts < 3 ? 2u
+			                                                         : 3u;
+			narrow_upper(lowest_of(next_after({version, first_non_zero})));
+		} else if (op == "~") {
+			narrow_lower(bound{from});
+			narrow_upper(
+			    lowest_of(next_after({version, std::min(parts, 2u)})));
+		} else if (op == ">=") {
+			narrow_lower(bound{from});
+		} else if (op == ">") {
+			if (parts == 3)
+				narrow_lower({version, false});
+			else
+				narrow_lower(lowest_of(next_after(*ver)));
+		} else if (op == "<") {
+			if (parts == 3)
+				narrow_upper({version, false});
+			else
+				narrow_upper(lowest_of(version));
+		} else if (op == "<=") {
+			if (parts == 3)
+				narrow_upper({version, true});
+			else
+				narrow_upper(lowest_of(next_after(*ver)));
+		}
+
+		return true;
+	}
+
+	bool version_constraint::contains(semver const& version) const {
+		if (stable_only_ && !version.prerelease.empty()) return false;
+		return !below(version) && !above(version);
+	}
+
+	int version_constraint::bound::compare(semver const& ver) const {
+		if (before_prereleases)
+			return numbers_of(ver) < numbers_of(version) ? -1 : 1;
+		if (ver < version) return -1;
+		return version < ver ? 1 : 0;
+	}
+
+	bool version_constraint::below(semver const& version) const {
+		if (!lower_) return false;
+		auto const position = lower_->compare(version);
+		return lower_->inclusive ? position < 0 : position <= 0;
+	}
+
+	bool version_constraint::above(semver const& version) const {
+		if (!upper_) return false;
+		auto const position = upper_->compare(version);
+		return upper_->inclusive ? position > 0 : position >= 0;
+	}
+
+	void version_constraint::narrow_lower(bound&& next) {
+		if (lower_) {
+			auto const position = compare(next, *lower_);
+			if (position < 0) return;
+			if (position == 0)
+				next.inclusive = next.inclusive && lower_->inclusive;
+		}
+		lower_ = std::move(next);
+	}
+
+	void version_constraint::narrow_upper(bound&& next) {
+		if (upper_) {
+			auto const position = compare(next, *upper_);
+			if (position > 0) return;
+			if (position == 0)
+				next.inclusive = next.inclusive && upper_->inclusive;
+		}
+		upper_ = std::move(next);
+	}
+}  // namespace distro
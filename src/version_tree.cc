@@ -0,0 +1,80 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "version_tree.hh"
+
+#include <charconv>
+#include <cstddef>
+
+namespace distro {
+	namespace {
+		std::array<std::uint64_t, 3> numbers_of(semver const& version) {
+			return {version.major, version.minor, version.patch};
+		}
+	}  // namespace
+
+	std::optional<version_prefix> version_prefix::from_string(
+	    std::string_view name) {
+		version_prefix result{};
+		while (result.size_ < result.parts_.size()) {
+			auto const dot = name.find('.');
+			auto const part = name.substr(0, dot);
+
+			auto const* end = part.data() + part.size();
+			auto const [ptr, ec] =
+			    std::from_chars(part.data(), end, result.parts_[result.size_]);
+			if (part.empty() || ec != std::errc{} || ptr != end)
+				return std::nullopt;
+			++result.size_;
+
+			if (dot == std::string_view::npos) return result;
+			name = name.substr(dot + 1);
+		}
+		return std::nullopt;
+	}
+
+	bool version_prefix::contains(semver const& version) const noexcept {
+		auto const numbers = numbers_of(version);
+		for (size_t index = 0; index < size_; ++index) {
+			if (numbers[index] != parts_[index]) return false;
+		}
+		return true;
+	}
+
+	bool version_prefix::extends(version_prefix const& parent) const noexcept {
+		if (size_ <= parent.size_) return false;
+		return std::equal(parent.parts_.begin(),
+		                  parent.parts_.begin() +
+		                      static_cast<ptrdiff_t>(parent.size_),
+		                  parts_.begin());
+	}
+
+	// The lowest version inside "X.Y" is X.Y.0-0 and the first one past
+	// it is X.(Y+1).0-0, each lower than any other version with the same
+	// numbers, so the numbers are enough to compare with.
+	bool version_prefix::below(semver const& version) const noexcept {
+		return size_ && end() <= numbers_of(version);
+	}
+
+	bool version_prefix::above(semver const& version) const noexcept {
+		if (!size_) return false;
+		numbers start{};
+		std::copy_n(parts_.begin(), size_, start.begin());
+		return numbers_of(version) < start;
+	}
+
+	bool version_prefix::ends_before(
+	    version_prefix const& other) const noexcept {
+		if (!other.size_) return size_ != 0;
+		if (!size_) return false;
+		return end() < other.end();
+	}
+
+	version_prefix::numbers version_prefix::end() const noexcept {
+		numbers result{};
+		std::copy_n(parts_.begin(), size_, result.begin());
+		++result[size_ - 1];
+		return result;
+	}
+}  // namespace distro
@@ -0,0 +1,194 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <distro/name_prefilter.hh>
+#include <distro/observer.hh>
+#include <distro/semver.hh>
+
+#include "dir_scan.hh"
+
+namespace distro {
+	// Leading numbers of all the versions inside a version directory: "15"
+	// stands for 15.x.y, "15.2" for 15.2.y, prereleases included. The top
+	// directory of a tree has an empty prefix, covering everything.
+	class version_prefix {
+	public:
+		// one to three dot-separated numbers
+		static std::optional<version_prefix> from_string(
+		    std::string_view name);
+
+		size_t size() const noexcept { return size_; }
+
+		// the version starts with all the numbers
+		bool contains(semver const& version) const noexcept;
+		// longer than the parent and starting with all its numbers
+		bool extends(version_prefix const& parent) const noexcept;
+		// every version inside is lower than the given one
+		bool below(semver const& version) const noexcept;
+		// every version inside is greater than the given one
+		bool above(semver const& version) const noexcept;
+		// the versions inside end before the ones of the other prefix
+		bool ends_before(version_prefix const& other) const noexcept;
+
+	private:
+		using numbers = std::array<std::uint64_t, 3>;
+		// the first version past the prefix, without a prerelease
+		numbers end() const noexcept;
+
+		std::array<unsigned, 3> parts_{};
+		size_t size_{};
+	};
+
+	struct version_directory {
+		fs::path path;
+		version_prefix prefix;
+	};
+
+	// one directory of a tree, read by walk_version_tree
+	template <typename Result>
+	struct directory_scan {
+		version_directory dir;
+		Result result;
+		std::error_code ec{};
+	};
+
+	// Reads srcdir and the version directories below it on up to `threads`
+	// workers (zero for one per hardware thread), newest versions first.
+	// Before a directory is read, skip(prefix) may leave it out, with all
+	// of its subtree. Each directory read starts with a copy of `blank`
+	// for its result and each of its files goes to
+	// visit(result, prefix, name, stats) and, once the directory is read,
+	// its result goes to done(result). Both skip and done are called under
+	// one lock, so they may share their state without any other. Entries
+	// named like a prefix, which does not extend the one of their parent,
+	// are not followed. The directories read are returned sorted by path,
+	// so their order does not depend on the timing of the workers. If any
+	// of the callbacks throws, the walk stops and the exception is
+	// rethrown here, once all the workers are done.
+	template <typename Result, typename Skip, typename Visit, typename Done>
+	std::vector<directory_scan<Result>> walk_version_tree(
+	    fs::path const& srcdir,
+	    name_prefilter const* prefilter,
+	    unsigned threads,
+	    scan_stats& stats,
+	    Result const& blank,
+	    Skip&& skip,
+	    Visit&& visit,
+	    Done&& done) {
+		// heap of the directories left to read, the newest on top
+		auto const older = [](version_directory const& lhs,
+		                      version_directory const& rhs) {
+			if (lhs.prefix.ends_before(rhs.prefix)) return true;
+			if (rhs.prefix.ends_before(lhs.prefix)) return false;
+			return rhs.path < lhs.path;
+		};
+
+		std::mutex mutex{};
+		std::condition_variable wake{};
+		std::vector<version_directory> pending{{srcdir, {}}};
+		size_t reading{};
+		std::vector<directory_scan<Result>> scans{};
+		// first exception of any worker; once set, all of them stop and it
+		// is rethrown after they are done
+		std::exception_ptr failure{};
+
+		// takes the directories off the heap until none is left and none
+		// is being read, which could add more; called with the lock held
+		auto const work = [&](std::unique_lock<std::mutex>& lock,
+		                      scan_stats& local) {
+			std::vector<version_directory> found{};
+			while (true) {
+				wake.wait(lock, [&] {
+					return failure || !pending.empty() || !reading;
+				});
+				if (failure || pending.empty()) break;
+
+				std::pop_heap(pending.begin(), pending.end(), older);
+				auto dir = std::move(pending.back());
+				pending.pop_back();
+				if (skip(dir.prefix)) {
+					++local.subtrees_pruned;
+					continue;
+				}
+
+				++reading;
+				lock.unlock();
+
+				directory_scan<Result> scan{std::move(dir), blank};
+				found.clear();
+				scan.ec = for_each_entry(
+				    scan.dir.path, local, prefilter,
+				    [](std::string_view name) {
+					    return !!version_prefix::from_string(name);
+				    },
+				    [&](std::string_view name) {
+					    auto const prefix = version_prefix::from_string(name);
+					    if (!prefix->extends(scan.dir.prefix)) return;
+					    found.push_back(
+					        {path_to(scan.dir.path, name), *prefix});
+				    },
+				    [&](std::string_view name) {
+					    visit(scan.result, scan.dir.prefix, name, local);
+				    });
+
+				lock.lock();
+				--reading;
+				done(scan.result);
+				for (auto& sub : found) {
+					pending.push_back(std::move(sub));
+					std::push_heap(pending.begin(), pending.end(), older);
+				}
+				scans.push_back(std::move(scan));
+				wake.notify_all();
+			}
+		};
+
+		auto const worker = [&] {
+			scan_stats local{};
+			std::unique_lock lock{mutex};
+			try {
+				work(lock, local);
+			} catch (...) {
+				if (!lock.owns_lock()) lock.lock();
+				if (!failure) failure = std::current_exception();
+				wake.notify_all();
+			}
+			stats += local;
+		};
+
+		if (!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		if (threads > 1) {
+			std::vector<std::jthread> pool{};
+			pool.reserve(threads);
+			for (unsigned index = 0; index < threads; ++index)
+				pool.emplace_back(worker);
+		} else {
+			worker();
+		}
+		if (failure) std::rethrow_exception(failure);
+
+		std::sort(scans.begin(), scans.end(),
+		          [](auto const& lhs, auto const& rhs) {
+			          return lhs.dir.path < rhs.dir.path;
+		          });
+		return scans;
+	}
+}  // namespace distro
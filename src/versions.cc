@@ -4,203 +4,1386 @@
 
 #include <distro/versions.hh>
 
-static std::string path_from(std::filesystem::path const& path) {
-	auto const u8gen = path.generic_u8string();
-#ifdef __cpp_lib_char8_t
-	return {reinterpret_cast<char const*>(u8gen.data()), u8gen.size()};
-#else
-	return u8gen;
-#endif
-}
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+#include "dir_scan.hh"
+#include "phase_timer.hh"
+#include "scan_index.hh"
+#include "version_tree.hh"
 
 namespace distro {
+	namespace {
+		StringSet const& any_architecture() {
+			static StringSet const empty{};
+			return empty;
+		}
+
+		bool provided_for(versions::Index::value_type const& item,
+		                  arch_filter const& architectures) {
+			return std::any_of(item.second.begin(), item.second.end(),
+			                   [&](package const& pkg) {
+				                   return architectures.accepts(pkg.arch);
+			                   });
+		}
+
+		// Stack memory for the few temporaries of a const query, a filter
+		// and the bounds of a constraint, so that neither the heap nor the
+		// resource of the set, which other threads may be using, is
+		// touched. Anything larger goes to the default resource.
+		class query_scratch {
+		public:
+			std::pmr::memory_resource* resource() noexcept {
+				return &resource_;
+			}
+
+		private:
+			std::array<std::byte, 512> buffer_;
+			std::pmr::monotonic_buffer_resource resource_{buffer_.data(),
+			                                              buffer_.size()};
+		};
+
+		// a regex from build_file_matcher carries its prefilter, any
+		// other regex has none
+		std::optional<name_prefilter> prefilter_for(
+		    regex_matcher const& matcher) {
+			return matcher.prefilter();
+		}
+
+		std::optional<name_prefilter> prefilter_for(
+		    file_matcher const& matcher) {
+			return matcher.prefilter();
+		}
+
+		// package built from the captures, if it is one of the
+		// architectures and, inside a version directory, of a version
+		// starting with its prefix; counts the rejections
+		std::optional<package> package_from(
+		    std::string_view name,
+		    file_match const* match,
+		    symbol_table& table,
+		    arch_filter const& architectures,
+		    scan_stats& stats,
+		    package::allocator_type const& alloc = {},
+		    version_prefix const* prefix = nullptr) {
+			if (!match) {
+				++stats.name_rejections;
+				return std::nullopt;
+			}
+
+			auto pkg = package::from_match(name, *match, table, alloc);
+			if (!pkg) {
+				++stats.semver_failures;
+				return std::nullopt;
+			}
+
+			if (prefix && !prefix->contains(pkg->version)) {
+				++stats.misplaced;
+				return std::nullopt;
+			}
+
+			if (!architectures.accepts(pkg->arch)) {
+				++stats.arch_rejections;
+				return std::nullopt;
+			}
+
+			++stats.packages_kept;
+			return pkg;
+		}
+
+		// Output is anything with push_back(package&&)
+		template <typename Matcher, typename Output>
+		std::error_code scan_directory(package_source const& source,
+		                               std::uint32_t root,
+		                               symbol_table& table,
+		                               StringSet const& architectures,
+		                               Matcher const& matcher,
+		                               Output& packages,
+		                               scan_stats& stats,
+		                               package::allocator_type const& alloc) {
+			arch_filter const filter{architectures, table};
+			return source.for_each_name(
+			    [&](std::string_view name) {
+				    auto const match = package::match(name, matcher);
+				    auto pkg = package_from(name, match ? &*match : nullptr,
+				                            table, filter, stats, alloc);
+				    if (!pkg) return;
+
+				    pkg->root = root;
+				    packages.push_back(std::move(*pkg));
+			    },
+			    stats);
+		}
+
+		template <typename Matcher, typename Output>
+		std::error_code scan_directory(package_source const& source,
+		                               symbol_table& table,
+		                               StringSet const& architectures,
+		                               Matcher const& matcher,
+		                               Output& packages,
+		                               observer* obs,
+		                               package::allocator_type const& alloc) {
+			scan_stats stats{};
+			std::error_code ec{};
+			{
+				phase_timer timer{obs, phase::scan};
+				ec = scan_directory(source, 0, table, architectures, matcher,
+				                    packages, stats, alloc);
+			}
+			if (obs) obs->scanned(source.root(), stats);
+			return ec;
+		}
+
+		// Keeps only the packages needed to resolve one query: all packages
+		// of the best candidate for the selected version seen so far and
+		// the newest provider of each component below it. Each package
+		// keeps its arrival number, so that the survivors can be put back
+		// in the directory order read_packages would have.
+		class selection {
+		public:
+			selection(std::optional<semver> const& requested,
+			          package::allocator_type const& alloc)
+			    : selected_{alloc}, providers_{alloc} {
+				if (requested)
+					query_ = version_constraint::exact(*requested, alloc);
+			}
+
+			void push_back(package&& pkg) {
+				auto const number = arrivals_++;
+
+				// nothing above the requested version is ever used
+				if (query_.above(pkg.version)) return;
+
+				if (eligible(pkg.version)) {
+					if (selected_.empty() ||
+					    selected_.front().second.version < pkg.version) {
+						for (auto& old : selected_)
+							offer(old.first, std::move(old.second));
+						selected_.clear();
+						selected_.emplace_back(number, std::move(pkg));
+						return;
+					}
+					if (selected_.front().second.version == pkg.version) {
+						selected_.emplace_back(number, std::move(pkg));
+						return;
+					}
+				}
+
+				offer(number, std::move(pkg));
+			}
+
+			// some packages were seen, but none of them could be selected
+			bool missing() const noexcept {
+				return arrivals_ && selected_.empty();
+			}
+
+			bool seen() const noexcept { return arrivals_ != 0; }
+
+			// version of the packages selected so far, if any
+			semver const* selected_version() const noexcept {
+				if (selected_.empty()) return nullptr;
+				return &selected_.front().second.version;
+			}
+
+			template <typename Visitor>
+			void for_each_kept(Visitor&& visit) const {
+				for (auto const& entry : selected_)
+					visit(entry.second);
+				for (auto const& [name, provider] : providers_)
+					visit(provider.second);
+			}
+
+			std::pmr::vector<package> take() {
+				auto numbered = std::move(selected_);
+				for (auto& [name, provider] : providers_)
+					numbered.push_back(std::move(provider));
+				providers_.clear();
+
+				std::sort(numbered.begin(), numbered.end(),
+				          [](auto const& lhs, auto const& rhs) {
+					          return lhs.first < rhs.first;
+				          });
+
+				std::pmr::vector<package> result{numbered.get_allocator()};
+				result.reserve(numbered.size());
+				for (auto& entry : numbered)
+					result.push_back(std::move(entry.second));
+				return result;
+			}
+
+		private:
+			using numbered_package = std::pair<size_t, package>;
+
+			// could find_selected pick this version for the query?
+			bool eligible(semver const& ver) const {
+				return query_.contains(ver);
+			}
+
+			void offer(size_t number, package&& pkg) {
+				if (!pkg.comp) return;
+
+				auto it = providers_.find(pkg.comp->name);
+				if (it == providers_.end()) {
+					auto const name = pkg.comp->name;
+					providers_.emplace(
+					    name, numbered_package{number, std::move(pkg)});
+					return;
+				}
+
+				// first package of a version stays the provider
+				if (it->second.second.version < pkg.version)
+					it->second = {number, std::move(pkg)};
+			}
+
+			// anything, if there was no requested version
+			version_constraint query_{};
+			size_t arrivals_{};
+			std::pmr::vector<numbered_package> selected_;
+			std::pmr::unordered_map<symbol, numbered_package> providers_;
+		};
+
+		// Output of the scan of stream_selected, showing each package to
+		// the sink before the selection gets it. Nothing above the
+		// requested version is ever selected and all the packages of the
+		// selected version are archives of the query, so the packages of
+		// the requested version itself are settled on arrival, in the
+		// order get_archives will list them in.
+		class streamed_selection {
+		public:
+			streamed_selection(selection& kept,
+			                   package_sink& sink,
+			                   symbol_table const& table,
+			                   fs::path const& root,
+			                   std::optional<semver> const& requested)
+			    : kept_{kept}
+			    , sink_{sink}
+			    , table_{table}
+			    , root_{root}
+			    , requested_{requested} {}
+
+			void push_back(package&& pkg) {
+				sink_.matched(pkg, table_);
+				if (requested_ && pkg.version == *requested_) {
+					auto archive = path_to(root_, pkg.filename);
+					archive.make_preferred();
+					sink_.settled(archive);
+					++settled_;
+				}
+				kept_.push_back(std::move(pkg));
+			}
+
+			size_t settled() const noexcept { return settled_; }
+
+		private:
+			selection& kept_;
+			package_sink& sink_;
+			symbol_table const& table_;
+			fs::path const& root_;
+			std::optional<semver> const& requested_;
+			size_t settled_{};
+		};
+
+		// directory of a tree, interning into its own table, as each root
+		// of read_roots does
+		template <typename Packages>
+		struct tree_part {
+			tree_part(StringSet const& architectures, Packages&& list)
+			    : packages{std::move(list)} {
+				filter = arch_filter{architectures, table};
+			}
+
+			symbol_table table{};
+			arch_filter filter{};
+			Packages packages;
+		};
+
+		// visit of walk_version_tree, putting the packages into the parts
+		template <typename Matcher>
+		auto tree_visitor(Matcher const& matcher) {
+			return [&matcher](auto& part, version_prefix const& prefix,
+			                  std::string_view name, scan_stats& stats) {
+				auto const match = package::match(name, matcher);
+				auto pkg =
+				    package_from(name, match ? &*match : nullptr, part.table,
+				                 part.filter, stats, {}, &prefix);
+				if (pkg) part.packages.push_back(std::move(*pkg));
+			};
+		}
+
+		// What the directories of a tree read so far tell about the
+		// query: the best version to select and the newest version of each
+		// of the listed components. Nothing below all of them can change
+		// the result, nor can anything above the requested version.
+		class tree_progress {
+		public:
+			tree_progress(std::optional<semver> const& requested,
+			              StringSet const& components)
+			    : requested_{requested} {
+				for (auto const& name : components)
+					newest_.emplace(name, std::nullopt);
+			}
+
+			bool skip(version_prefix const& prefix) const {
+				if (requested_ && prefix.above(*requested_)) return true;
+				if (!selected_ || newest_.empty() ||
+				    !prefix.below(*selected_))
+					return false;
+				return std::all_of(
+				    newest_.begin(), newest_.end(), [&](auto const& entry) {
+					    return entry.second && prefix.below(*entry.second);
+				    });
+			}
+
+			void update(symbol_table const& table, selection const& found) {
+				auto const* best = found.selected_version();
+				if (best && (!selected_ || *selected_ < *best))
+					selected_ = *best;
+
+				found.for_each_kept([&](package const& pkg) {
+					if (!pkg.comp) return;
+					auto it = newest_.find(table.name(pkg.comp->name));
+					if (it == newest_.end()) return;
+					if (!it->second || *it->second < pkg.version)
+						it->second = pkg.version;
+				});
+			}
+
+		private:
+			std::optional<semver> requested_;
+			std::optional<semver> selected_{};
+			std::map<std::string, std::optional<semver>, std::less<>>
+			    newest_{};
+		};
+
+		// Moves what the directories of a tree kept into one table, in the
+		// order of the directories, rooting each package at its directory.
+		// Archive names found in an earlier directory are dropped. Errors
+		// are reported here, after the workers are done, since the log is
+		// not reentrant.
+		template <typename Packages, typename Take, typename Add>
+		void merge_tree(
+		    std::vector<directory_scan<tree_part<Packages>>>& scans,
+		    std::vector<fs::path>& roots,
+		    symbol_table& table,
+		    errors const& log,
+		    Take&& take,
+		    Add&& add) {
+			std::vector<symbol> remap{};
+			std::unordered_set<std::string> seen{};
+			for (auto& [dir, part, ec] : scans) {
+				if (ec) log.src_dir(ec);
+
+				auto packages = take(part.packages);
+				if (packages.empty()) continue;
+
+				remap.clear();
+				for (symbol id = 0; id < part.table.size(); ++id)
+					remap.push_back(table.intern(part.table.name(id)));
+
+				auto const root = static_cast<std::uint32_t>(roots.size());
+				roots.push_back(dir.path);
+				for (auto& pkg : packages) {
+					if (!seen.emplace(pkg.filename).second) continue;
+					pkg.root = root;
+					pkg.arch = remap[pkg.arch];
+					if (pkg.comp) pkg.comp->name = remap[pkg.comp->name];
+					add(std::move(pkg));
+				}
+			}
+		}
+	}  // namespace
+
+	versions::versions(allocator_type const& alloc)
+	    : packages{alloc}, items{alloc}, providers{alloc}, listing{alloc} {}
+
+	versions::versions(versions const& other)
+	    : roots{other.roots}, table{other.table}, packages{other.packages} {
+		build_index();
+	}
+
+	versions::versions(versions const& other, allocator_type const& alloc)
+	    : roots{other.roots}
+	    , table{other.table}
+	    , packages{other.packages, alloc}
+	    , items{alloc}
+	    , providers{alloc}
+	    , listing{alloc} {
+		build_index();
+	}
+
+	// the spans of the index would still view the old storage, if the
+	// packages had to be copied to the new resource
+	versions::versions(versions&& other, allocator_type const& alloc)
+	    : roots{std::move(other.roots)}
+	    , table{std::move(other.table)}
+	    , packages{std::move(other.packages), alloc}
+	    , items{alloc}
+	    , providers{alloc}
+	    , listing{alloc} {
+		build_index();
+	}
+
+	versions& versions::operator=(versions const& other) {
+		if (this != &other) {
+			roots = other.roots;
+			table = other.table;
+			packages = other.packages;
+			build_index();
+		}
+		return *this;
+	}
+
+	// The allocator does not propagate on move assignment, so, if the two
+	// differ, the packages are moved one by one into storage of this set
+	// and the index has to view them there.
+	versions& versions::operator=(versions&& other) {
+		if (this != &other) {
+			auto const same = get_allocator() == other.get_allocator();
+			roots = std::move(other.roots);
+			table = std::move(other.table);
+			packages = std::move(other.packages);
+			if (same) {
+				items = std::move(other.items);
+				providers = std::move(other.providers);
+				listing = std::move(other.listing);
+			} else {
+				build_index();
+			}
+		}
+		return *this;
+	}
+
+	std::vector<fs::path> versions::get_archives(
+	    fs::path const& srcdir,
+	    StringSet const& architectures,
+	    std::optional<semver>& requested,
+	    regex_matcher const& file_matcher,
+	    bool debug,
+	    std::ostream& debug_out,
+	    errors& log,
+	    observer* obs) {
+		return get_archives_impl(srcdir, architectures, requested,
+		                         file_matcher, debug, debug_out, log, obs);
+	}
+
 	std::vector<fs::path> versions::get_archives(
 	    fs::path const& srcdir,
 	    StringSet const& architectures,
 	    std::optional<semver>& requested,
-	    std::regex const& file_matcher,
+	    file_matcher const& matcher,
 	    bool debug,
 	    std::ostream& debug_out,
+	    errors& log,
+	    observer* obs) {
+		return get_archives_impl(srcdir, architectures, requested, matcher,
+		                         debug, debug_out, log, obs);
+	}
+
+	std::vector<versions::platform_archives> versions::get_platform_archives(
+	    fs::path const& srcdir,
+	    std::vector<StringSet> const& architectures,
+	    std::optional<semver> const& requested,
+	    regex_matcher const& file_matcher,
+	    errors& log) {
+		return get_platform_archives_impl(srcdir, architectures, requested,
+		                                  file_matcher, log);
+	}
+
+	std::vector<versions::platform_archives> versions::get_platform_archives(
+	    fs::path const& srcdir,
+	    std::vector<StringSet> const& architectures,
+	    std::optional<semver> const& requested,
+	    file_matcher const& matcher,
 	    errors& log) {
-		auto self = read_packages(srcdir, architectures, file_matcher, log);
+		return get_platform_archives_impl(srcdir, architectures, requested,
+		                                  matcher, log);
+	}
+
+	versions versions::read_packages(package_source const& source,
+	                                 StringSet const& architectures,
+	                                 regex_matcher const& matcher,
+	                                 errors const& log,
+	                                 observer* obs,
+	                                 allocator_type const& alloc) {
+		return read_packages_impl(source, architectures, matcher, log, obs,
+		                          alloc);
+	}
+
+	versions versions::read_packages(fs::path const& srcdir,
+	                                 StringSet const& architectures,
+	                                 regex_matcher const& matcher,
+	                                 errors const& log,
+	                                 observer* obs,
+	                                 allocator_type const& alloc) {
+		return read_packages_impl(
+		    directory_source{srcdir, prefilter_for(matcher)}, architectures,
+		    matcher, log, obs, alloc);
+	}
+
+	versions versions::read_packages(package_source const& source,
+	                                 StringSet const& architectures,
+	                                 file_matcher const& matcher,
+	                                 errors const& log,
+	                                 observer* obs,
+	                                 allocator_type const& alloc) {
+		return read_packages_impl(source, architectures, matcher, log, obs,
+		                          alloc);
+	}
+
+	versions versions::read_packages(fs::path const& srcdir,
+	                                 StringSet const& architectures,
+	                                 file_matcher const& matcher,
+	                                 errors const& log,
+	                                 observer* obs,
+	                                 allocator_type const& alloc) {
+		return read_packages_impl(
+		    directory_source{srcdir, prefilter_for(matcher)}, architectures,
+		    matcher, log, obs, alloc);
+	}
+
+	versions versions::read_roots(std::vector<fs::path> const& srcdirs,
+	                              StringSet const& architectures,
+	                              regex_matcher const& matcher,
+	                              errors const& log,
+	                              unsigned threads) {
+		return read_roots_impl(srcdirs, architectures, matcher, log, threads);
+	}
+
+	versions versions::read_roots(std::vector<fs::path> const& srcdirs,
+	                              StringSet const& architectures,
+	                              file_matcher const& matcher,
+	                              errors const& log,
+	                              unsigned threads) {
+		return read_roots_impl(srcdirs, architectures, matcher, log, threads);
+	}
+
+	versions versions::read_tree(fs::path const& srcdir,
+	                             StringSet const& architectures,
+	                             regex_matcher const& matcher,
+	                             errors const& log,
+	                             unsigned threads,
+	                             observer* obs) {
+		return read_tree_impl(srcdir, architectures, matcher, log, threads,
+		                      obs);
+	}
+
+	versions versions::read_tree(fs::path const& srcdir,
+	                             StringSet const& architectures,
+	                             file_matcher const& matcher,
+	                             errors const& log,
+	                             unsigned threads,
+	                             observer* obs) {
+		return read_tree_impl(srcdir, architectures, matcher, log, threads,
+		                      obs);
+	}
+
+	versions versions::read_tree_selected(
+	    fs::path const& srcdir,
+	    StringSet const& architectures,
+	    std::optional<semver> const& requested,
+	    StringSet const& components,
+	    regex_matcher const& matcher,
+	    errors const& log,
+	    unsigned threads,
+	    observer* obs) {
+		return read_tree_selected_impl(srcdir, architectures, requested,
+		                               components, matcher, log, threads,
+		                               obs);
+	}
+
+	versions versions::read_tree_selected(
+	    fs::path const& srcdir,
+	    StringSet const& architectures,
+	    std::optional<semver> const& requested,
+	    StringSet const& components,
+	    file_matcher const& matcher,
+	    errors const& log,
+	    unsigned threads,
+	    observer* obs) {
+		return read_tree_selected_impl(srcdir, architectures, requested,
+		                               components, matcher, log, threads,
+		                               obs);
+	}
+
+	versions versions::read_selected(fs::path const& srcdir,
+	                                 StringSet const& architectures,
+	                                 std::optional<semver> const& requested,
+	                                 regex_matcher const& matcher,
+	                                 errors const& log,
+	                                 observer* obs,
+	                                 allocator_type const& alloc) {
+		return read_selected_impl(
+		    directory_source{srcdir, prefilter_for(matcher)}, architectures,
+		    requested, matcher, log, obs, alloc);
+	}
+
+	versions versions::read_selected(fs::path const& srcdir,
+	                                 StringSet const& architectures,
+	                                 std::optional<semver> const& requested,
+	                                 file_matcher const& matcher,
+	                                 errors const& log,
+	                                 observer* obs,
+	                                 allocator_type const& alloc) {
+		return read_selected_impl(
+		    directory_source{srcdir, prefilter_for(matcher)}, architectures,
+		    requested, matcher, log, obs, alloc);
+	}
+
+	versions versions::stream_selected(package_source const& source,
+	                                   StringSet const& architectures,
+	                                   std::optional<semver> const& requested,
+	                                   regex_matcher const& matcher,
+	                                   package_sink& sink,
+	                                   errors const& log,
+	                                   observer* obs,
+	                                   allocator_type const& alloc) {
+		return stream_selected_impl(source, architectures, requested, matcher,
+		                            sink, log, obs, alloc);
+	}
+
+	versions versions::stream_selected(package_source const& source,
+	                                   StringSet const& architectures,
+	                                   std::optional<semver> const& requested,
+	                                   file_matcher const& matcher,
+	                                   package_sink& sink,
+	                                   errors const& log,
+	                                   observer* obs,
+	                                   allocator_type const& alloc) {
+		return stream_selected_impl(source, architectures, requested, matcher,
+		                            sink, log, obs, alloc);
+	}
+
+	versions versions::stream_selected(fs::path const& srcdir,
+	                                   StringSet const& architectures,
+	                                   std::optional<semver> const& requested,
+	                                   regex_matcher const& matcher,
+	                                   package_sink& sink,
+	                                   errors const& log,
+	                                   observer* obs,
+	                                   allocator_type const& alloc) {
+		return stream_selected_impl(
+		    directory_source{srcdir, prefilter_for(matcher)}, architectures,
+		    requested, matcher, sink, log, obs, alloc);
+	}
+
+	versions versions::stream_selected(fs::path const& srcdir,
+	                                   StringSet const& architectures,
+	                                   std::optional<semver> const& requested,
+	                                   file_matcher const& matcher,
+	                                   package_sink& sink,
+	                                   errors const& log,
+	                                   observer* obs,
+	                                   allocator_type const& alloc) {
+		return stream_selected_impl(
+		    directory_source{srcdir, prefilter_for(matcher)}, architectures,
+		    requested, matcher, sink, log, obs, alloc);
+	}
+
+	versions versions::read_cached(fs::path const& srcdir,
+	                               fs::path const& index_file,
+	                               StringSet const& architectures,
+	                               file_matcher const& matcher,
+	                               errors const& log) {
+		symbol_table table{};
+		std::pmr::vector<package> packages{};
+		if (!scan_index::load(srcdir, index_file, architectures, matcher,
+		                      table, packages)) {
+			auto const ec =
+			    scan_index::rebuild(srcdir, index_file, architectures,
+			                        matcher, table, packages);
+			if (ec) log.src_dir(ec);
+		}
+
+		return from_packages({srcdir}, std::move(table), std::move(packages));
+	}
+
+	std::vector<versions> versions::read_many(fs::path const& srcdir,
+	                                          StringSet const& architectures,
+	                                          package_matcher const& matcher,
+	                                          errors const& log,
+	                                          observer* obs) {
+		return read_many(directory_source{srcdir}, architectures, matcher,
+		                 log, obs);
+	}
+
+	std::vector<versions> versions::read_many(package_source const& source,
+	                                          StringSet const& architectures,
+	                                          package_matcher const& matcher,
+	                                          errors const& log,
+	                                          observer* obs) {
+		// one table for the whole scan, each set gets a copy
+		symbol_table table{};
+		arch_filter const filter{architectures, table};
+		std::vector<std::pmr::vector<package>> packages(matcher.size());
+		scan_stats stats{};
+		std::error_code ec{};
+		{
+			phase_timer timer{obs, phase::scan};
+			ec = source.for_each_name(
+			    [&](std::string_view name) {
+				    auto const match = matcher.match(name);
+				    auto pkg = package_from(
+				        name, match ? &match->captures : nullptr, table,
+				        filter, stats);
+				    if (!pkg) return;
+				    packages[match->package].push_back(std::move(*pkg));
+			    },
+			    stats);
+		}
+		if (obs) obs->scanned(source.root(), stats);
+		if (ec) log.src_dir(ec);
+
+		std::vector<versions> result{};
+		result.reserve(packages.size());
+		for (auto& list : packages) {
+			result.push_back(from_packages({source.root()}, symbol_table{table},
+			                               std::move(list), obs));
+		}
+		return result;
+	}
+
+	template <typename Matcher>
+	std::vector<fs::path> versions::get_archives_impl(
+	    fs::path const& srcdir,
+	    StringSet const& architectures,
+	    std::optional<semver>& requested,
+	    Matcher const& matcher,
+	    bool debug,
+	    std::ostream& debug_out,
+	    errors& log,
+	    observer* obs) {
+		// debug output shows all the versions, otherwise the scan may keep
+		// only what the query needs
+		auto self =
+		    debug ? read_packages(srcdir, architectures, matcher, log, obs)
+		          : read_selected(srcdir, architectures, requested, matcher,
+		                          log, obs);
 		if (self.empty()) {
 			debug_out << "No versions found\n";
 			std::exit(0);
 		}
 
-		auto selected = self.find_selected(requested, log);
-		auto comps = self.components(selected);
-		auto archives = comps.get_archives();
+		auto selected = self.find_selected(requested, log, obs);
+		auto comps = self.components(selected, obs);
+		auto archives = comps.get_archives(obs);
 
 		if (debug) comps.debug_print(debug_out);
 
 		return archives;
 	}
 
-	versions versions::read_packages(fs::path const& srcdir,
-	                                 StringSet const& architectures,
-	                                 std::regex const& matcher,
-	                                 errors const& log) {
-		std::error_code ec;
-		fs::directory_iterator dirent{srcdir, ec};
+	template <typename Matcher>
+	std::vector<versions::platform_archives>
+	versions::get_platform_archives_impl(
+	    fs::path const& srcdir,
+	    std::vector<StringSet> const& architectures,
+	    std::optional<semver> const& requested,
+	    Matcher const& matcher,
+	    errors& log) {
+		// a set accepting anything makes the whole scan unfiltered
+		StringSet all{};
+		auto const unfiltered =
+		    std::any_of(architectures.begin(), architectures.end(),
+		                [](StringSet const& set) { return set.empty(); });
+		if (!unfiltered) {
+			for (auto const& set : architectures)
+				all.insert(set.begin(), set.end());
+		}
+
+		auto self = read_packages(srcdir, all, matcher, log);
+
+		std::vector<platform_archives> result{};
+		result.reserve(architectures.size());
+		for (auto const& set : architectures) {
+			auto& platform = result.emplace_back();
+			if (!self.provides(set)) continue;
+
+			platform.version = requested;
+			auto selected = self.find_selected(platform.version, log, set);
+			platform.archives = self.components(selected, set).get_archives();
+		}
+
+		return result;
+	}
+
+	template <typename Matcher>
+	versions versions::read_packages_impl(package_source const& source,
+	                                      StringSet const& architectures,
+	                                      Matcher const& matcher,
+	                                      errors const& log,
+	                                      observer* obs,
+	                                      allocator_type const& alloc) {
+		symbol_table table{};
+		std::pmr::vector<package> packages{alloc};
+		auto const ec = scan_directory(source, table, architectures, matcher,
+		                               packages, obs, alloc);
 		if (ec) log.src_dir(ec);
 
-		versions versions{};
-		for (auto const& entry : dirent) {
-			if (entry.is_directory(ec)) continue;
-			if (ec) continue;
+		return from_packages({source.root()}, std::move(table),
+		                     std::move(packages), obs);
+	}
 
-			auto pkg = package::from_string(
-			    entry.path(), path_from(entry.path().filename()), matcher);
+	template <typename Matcher>
+	versions versions::read_selected_impl(
+	    package_source const& source,
+	    StringSet const& architectures,
+	    std::optional<semver> const& requested,
+	    Matcher const& matcher,
+	    errors const& log,
+	    observer* obs,
+	    allocator_type const& alloc) {
+		symbol_table table{};
+		selection packages{requested, alloc};
+		auto const ec = scan_directory(source, table, architectures, matcher,
+		                               packages, obs, alloc);
+		if (ec) log.src_dir(ec);
+		if (requested && packages.missing()) log.version_missing(*requested);
 
-			if (!pkg) continue;
-			if (!architectures.empty() &&
-			    architectures.find(pkg->arch) == architectures.end())
-				continue;
+		return from_packages({source.root()}, std::move(table),
+		                     packages.take(), obs);
+	}
 
-			versions.items[pkg->version].emplace_back(std::move(*pkg));
-		}
+	template <typename Matcher>
+	versions versions::stream_selected_impl(
+	    package_source const& source,
+	    StringSet const& architectures,
+	    std::optional<semver> const& requested,
+	    Matcher const& matcher,
+	    package_sink& sink,
+	    errors const& log,
+	    observer* obs,
+	    allocator_type const& alloc) {
+		symbol_table table{};
+		selection packages{requested, alloc};
+		streamed_selection stream{packages, sink, table, source.root(),
+		                          requested};
+		auto const ec = scan_directory(source, table, architectures, matcher,
+		                               stream, obs, alloc);
+		if (ec) log.src_dir(ec);
+		if (requested && packages.missing()) log.version_missing(*requested);
+
+		auto self = from_packages({source.root()}, std::move(table),
+		                          packages.take(), obs);
+		if (self.empty()) return self;
 
-		return versions;
+		// the rest can be settled only now; the ones settled during the
+		// scan open the list
+		auto version = requested;
+		auto const selected = self.find_selected(version, log, obs);
+		auto comps = self.components(selected, obs, alloc);
+		comps.select(obs);
+		for (auto const* pkg : comps.packages().subspan(stream.settled()))
+			sink.settled(self.archive(*pkg));
+
+		return self;
 	}
 
-	versions::iterator versions::find_selected(std::optional<semver>& requested,
-	                                           errors const& log) {
-		// PRE: !items.empty()
-		if (!requested) requested = std::prev(items.end())->first;
-
-		auto selected = items.find(*requested);
-		if (selected == items.end() && requested->prerelease.empty()) {
-			auto cur = items.rbegin();
-			auto end = items.rend();
-			for (; cur != end; ++cur) {
-				auto const& ver = cur->first;
-				if (ver.major == requested->major &&
-				    ver.minor == requested->minor &&
-				    ver.patch == requested->patch) {
-					selected = std::prev(cur.base());
-					break;
+	template <typename Matcher>
+	versions versions::read_roots_impl(std::vector<fs::path> const& srcdirs,
+	                                   StringSet const& architectures,
+	                                   Matcher const& matcher,
+	                                   errors const& log,
+	                                   unsigned threads) {
+		// each worker interns into the table of its root, they are merged
+		// into the first one afterwards
+		struct root_scan {
+			symbol_table table{};
+			std::pmr::vector<package> packages{};
+			std::error_code ec{};
+			// thrown by the scan, rethrown after the workers are done
+			std::exception_ptr exception{};
+		};
+		std::vector<root_scan> scans(srcdirs.size());
+
+		std::atomic<size_t> next_root{0};
+		auto const worker = [&] {
+			for (auto root = next_root++; root < srcdirs.size();
+			     root = next_root++) {
+				auto& scan = scans[root];
+				try {
+					scan_stats stats{};
+					scan.ec = scan_directory(
+					    directory_source{srcdirs[root],
+					                     prefilter_for(matcher)},
+					    static_cast<std::uint32_t>(root), scan.table,
+					    architectures, matcher, scan.packages, stats, {});
+				} catch (...) {
+					scan.exception = std::current_exception();
 				}
 			}
+		};
+
+		if (!threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		auto const workers = std::min(size_t{threads}, srcdirs.size());
+		if (workers > 1) {
+			std::vector<std::jthread> pool{};
+			pool.reserve(workers);
+			for (size_t index = 0; index < workers; ++index)
+				pool.emplace_back(worker);
+		} else {
+			worker();
 		}
 
-		if (selected == items.end()) log.version_missing(*requested);
+		// the log is not reentrant, so errors are reported once all threads
+		// are done, in the order of the roots
+		for (auto const& scan : scans) {
+			if (scan.exception) std::rethrow_exception(scan.exception);
+			if (scan.ec) log.src_dir(scan.ec);
+		}
 
-		return selected;
-	}
+		size_t total{};
+		for (auto const& scan : scans)
+			total += scan.packages.size();
 
-	versions::comp_list versions::components(iterator const& selected) {
-		StringSet comps;
-		for (auto& [ver, pkgs] : *this) {
-			for (auto const& pkg : pkgs) {
-				if (pkg.comp) comps.insert(pkg.comp->name);
+		symbol_table table{};
+		std::vector<symbol> remap{};
+		std::pmr::vector<package> packages{};
+		packages.reserve(total);
+		std::unordered_set<std::string> seen{};
+		seen.reserve(total);
+		for (auto& scan : scans) {
+			remap.clear();
+			for (symbol id = 0; id < scan.table.size(); ++id)
+				remap.push_back(table.intern(scan.table.name(id)));
+
+			for (auto& pkg : scan.packages) {
+				if (!seen.emplace(pkg.filename).second) continue;
+				pkg.arch = remap[pkg.arch];
+				if (pkg.comp) pkg.comp->name = remap[pkg.comp->name];
+				packages.push_back(std::move(pkg));
 			}
-			if (ver == selected->first) break;
 		}
 
-		return {this, selected, std::move(comps)};
+		return from_packages(std::vector<fs::path>(srcdirs), std::move(table),
+		                     std::move(packages));
 	}
 
-	std::vector<fs::path> versions::comp_list::get_archives() {
-		std::vector<fs::path> archives{};
-		archives.reserve(list_.size());
-
-		for (auto& pkg : selected_->second) {
-			pkg.selected = true;
-			archives.push_back(pkg.archive);
-			if (!pkg.comp) continue;
+	template <typename Matcher>
+	versions versions::read_tree_impl(fs::path const& srcdir,
+	                                  StringSet const& architectures,
+	                                  Matcher const& matcher,
+	                                  errors const& log,
+	                                  unsigned threads,
+	                                  observer* obs) {
+		using part = tree_part<std::pmr::vector<package>>;
+		auto const prefilter = prefilter_for(matcher);
 
-			auto where = list_.find(pkg.comp->name);
-			if (where != list_.end()) list_.erase(where);
+		scan_stats stats{};
+		std::vector<directory_scan<part>> scans{};
+		{
+			phase_timer timer{obs, phase::scan};
+			scans = walk_version_tree(
+			    srcdir, prefilter ? &*prefilter : nullptr, threads, stats,
+			    part{architectures, {}},
+			    [](version_prefix const&) { return false; },
+			    tree_visitor(matcher), [](part&) {});
 		}
+		if (obs) obs->scanned(srcdir, stats);
 
-		if (!list_.empty()) {
-			auto revCurr = std::reverse_iterator{selected_};
-			auto revEnd = parent_->rend();
-			for (; !list_.empty() && revCurr != revEnd; ++revCurr) {
-				for (auto& pkg : revCurr->second) {
-					if (!pkg.comp) continue;
+		size_t total{};
+		for (auto const& scan : scans)
+			total += scan.result.packages.size();
 
-					auto where = list_.find(pkg.comp->name);
-					if (where == list_.end()) continue;
+		std::vector<fs::path> roots{};
+		symbol_table table{};
+		std::pmr::vector<package> packages{};
+		packages.reserve(total);
+		merge_tree(
+		    scans, roots, table, log,
+		    [](std::pmr::vector<package>& list) { return std::move(list); },
+		    [&](package&& pkg) { packages.push_back(std::move(pkg)); });
 
-					pkg.selected = true;
-					archives.push_back(pkg.archive);
-					list_.erase(where);
-				}
-			}
+		return from_packages(std::move(roots), std::move(table),
+		                     std::move(packages), obs);
+	}
+
+	template <typename Matcher>
+	versions versions::read_tree_selected_impl(
+	    fs::path const& srcdir,
+	    StringSet const& architectures,
+	    std::optional<semver> const& requested,
+	    StringSet const& components,
+	    Matcher const& matcher,
+	    errors const& log,
+	    unsigned threads,
+	    observer* obs) {
+		// each directory keeps what its own selection would, which is all
+		// the selection of the whole tree could take from it
+		using part = tree_part<selection>;
+		auto const prefilter = prefilter_for(matcher);
+		tree_progress progress{requested, components};
+
+		scan_stats stats{};
+		std::vector<directory_scan<part>> scans{};
+		{
+			phase_timer timer{obs, phase::scan};
+			scans = walk_version_tree(
+			    srcdir, prefilter ? &*prefilter : nullptr, threads, stats,
+			    part{architectures, selection{requested, {}}},
+			    [&](version_prefix const& prefix) {
+				    return progress.skip(prefix);
+			    },
+			    tree_visitor(matcher), [&](part& found) {
+				    progress.update(found.table, found.packages);
+			    });
 		}
+		if (obs) obs->scanned(srcdir, stats);
 
-		return archives;
+		std::vector<fs::path> roots{};
+		symbol_table table{};
+		selection packages{requested, {}};
+		bool seen = false;
+		merge_tree(
+		    scans, roots, table, log,
+		    [&](selection& kept) {
+			    seen |= kept.seen();
+			    return kept.take();
+		    },
+		    [&](package&& pkg) { packages.push_back(std::move(pkg)); });
+		if (requested && seen && !packages.selected_version())
+			log.version_missing(*requested);
+
+		return from_packages(std::move(roots), std::move(table),
+		                     packages.take(), obs);
 	}
 
-	void versions::comp_list::debug_print(std::ostream& out) {
-		if (!list_.empty()) {
-			out << "Possibly-missing component(s):";
-			for (auto const& comp : list_) {
-				out << ' ' << comp;
+	versions versions::from_packages(std::vector<fs::path>&& roots,
+	                                 symbol_table&& table,
+	                                 std::pmr::vector<package>&& packages,
+	                                 observer* obs) {
+		phase_timer timer{obs, phase::index};
+		versions result{packages.get_allocator()};
+		result.roots = std::move(roots);
+		result.table = std::move(table);
+		result.packages = std::move(packages);
+
+		// stable, to keep the directory order inside each version
+		std::stable_sort(result.packages.begin(), result.packages.end(),
+		                 [](package const& lhs, package const& rhs) {
+			                 return lhs.version < rhs.version;
+		                 });
+		result.build_index();
+
+		return result;
+	}
+
+	void versions::build_index() {
+		items.clear();
+		providers.clear();
+		providers.resize(table.size());
+		listing.clear();
+		listing.reserve(packages.size());
+
+		// the names are compared once, the packages by their ranks
+		std::pmr::vector<symbol> by_name(table.size(), get_allocator());
+		std::iota(by_name.begin(), by_name.end(), symbol{});
+		std::sort(by_name.begin(), by_name.end(),
+		          [&](symbol lhs, symbol rhs) {
+			          return table.name(lhs) < table.name(rhs);
+		          });
+		std::pmr::vector<std::uint32_t> rank(table.size(), get_allocator());
+		for (size_t index = 0; index < by_name.size(); ++index)
+			rank[by_name[index]] = static_cast<std::uint32_t>(index);
+
+		auto const listed_before = [&](std::uint32_t lhs_pos,
+		                               std::uint32_t rhs_pos) {
+			auto const& lhs = packages[lhs_pos].comp;
+			auto const& rhs = packages[rhs_pos].comp;
+			if (!lhs) return !!rhs;
+			if (!rhs) return false;
+			if (lhs->name != rhs->name)
+				return rank[lhs->name] < rank[rhs->name];
+			return lhs->version < rhs->version;
+		};
+
+		auto it = packages.begin();
+		auto const end = packages.end();
+		while (it != end) {
+			auto const& ver = it->version;
+			auto const next = std::find_if(
+			    std::next(it), end,
+			    [&](package const& pkg) { return !(pkg.version == ver); });
+
+			auto const version = items.size();
+			auto const first = static_cast<ptrdiff_t>(listing.size());
+			for (auto pkg = it; pkg != next; ++pkg) {
+				auto const pos = static_cast<size_t>(pkg - packages.begin());
+				listing.push_back(static_cast<std::uint32_t>(pos));
+				if (!pkg->comp) continue;
+				providers[pkg->comp->name].push_back({version, pos});
 			}
-			out << "\n\n";
+			std::stable_sort(std::next(listing.begin(), first), listing.end(),
+			                 listed_before);
+
+			items.emplace_back(ver, std::span{it, next});
+			it = next;
 		}
+	}
 
-		for (auto const& [ver, const_pkgs] : *parent_) {
-			auto pkgs = const_pkgs;
-			std::sort(std::begin(pkgs), std::end(pkgs),
-			          [](auto const& lhs, auto const& rhs) {
-				          if (!lhs.comp) return !!rhs.comp;
-				          if (!rhs.comp) return false;
-				          if (lhs.comp->name != rhs.comp->name)
-					          return lhs.comp->name < rhs.comp->name;
-				          return lhs.comp->version < rhs.comp->version;
-			          });
+	std::optional<versions::component_provider> versions::newest_provider(
+	    symbol comp,
+	    size_t below,
+	    arch_filter const& architectures) const {
+		if (comp >= providers.size()) return std::nullopt;
+		auto const& list = providers[comp];
 
-			auto const any_selected = [&] {
-				for (auto const& pkg : pkgs) {
-					if (pkg.selected) return true;
-				}
-				return false;
-			}();
+		auto it = std::lower_bound(list.begin(), list.end(), below,
+		                           [](component_provider const& prov,
+		                              size_t version) {
+			                           return prov.version < version;
+		                           });
+
+		// once a version has an accepted package, only the earlier packages
+		// of the same version may take its place
+		std::optional<component_provider> found{};
+		while (it != list.begin()) {
+			--it;
+			if (found && it->version != found->version) break;
+			if (architectures.accepts(packages[it->package].arch)) found = *it;
+		}
+		return found;
+	}
+
+	fs::path versions::archive(package const& pkg) const {
+		auto result = path_to(roots[pkg.root], pkg.filename);
+		result.make_preferred();
+		return result;
+	}
+
+	versions::iterator versions::find_selected(std::optional<semver>& requested,
+	                                           errors const& log,
+	                                           observer* obs) const {
+		return find_selected(requested, log, any_architecture(), obs);
+	}
 
-			auto const all_selected = ver == selected_->first;
+	versions::comp_list versions::components(
+	    iterator const& selected,
+	    observer* obs,
+	    allocator_type const& alloc) const {
+		return components(selected, any_architecture(), obs, alloc);
+	}
 
-			if (all_selected)
-				out << "\x1b[96m";
-			else if (any_selected)
-				out << "\x1b[36m";
-			else
-				out << "\x1b[90m";
+	versions::iterator versions::find_selected(
+	    std::optional<semver>& requested,
+	    errors const& log,
+	    StringSet const& architectures,
+	    observer* obs) const {
+		phase_timer timer{obs, phase::select};
+		query_scratch scratch{};
+		arch_filter const filter{architectures, symbols(), scratch.resource()};
+		// PRE: provides(architectures)
+		if (!requested) {
+			auto const newest = std::find_if(
+			    items.rbegin(), items.rend(),
+			    [&](auto const& item) { return provided_for(item, filter); });
+			requested = newest->first;
+		}
 
-			out << ver.to_string() << "\x1b[0m";
+		auto const selected = find_newest(
+		    version_constraint::exact(*requested, scratch.resource()), filter);
+		if (selected == items.end()) log.version_missing(*requested);
 
-			bool diff_arch = false;
-			for (size_t i = 1; i < pkgs.size(); ++i) {
-				if (pkgs[i].arch != pkgs[i - 1].arch) {
-					diff_arch = true;
+		return selected;
+	}
+
+	versions::comp_list versions::components(
+	    iterator const& selected,
+	    StringSet const& architectures,
+	    observer* obs,
+	    allocator_type const& alloc) const {
+		phase_timer timer{obs, phase::components};
+		arch_filter filter{architectures, symbols(), alloc};
+		auto const last = static_cast<size_t>(selected - items.begin());
+		symbol_set comps{alloc};
+		for (symbol comp = 0; comp < providers.size(); ++comp) {
+			for (auto const& prov : providers[comp]) {
+				if (prov.version > last) break;
+				if (filter.accepts(packages[prov.package].arch)) {
+					comps.insert(comp);
 					break;
 				}
 			}
+		}
+
+		return {this, selected, std::move(comps), std::move(filter), alloc};
+	}
+
+	versions::iterator versions::find_newest(
+	    version_constraint const& query) const {
+		return find_newest(query, any_architecture());
+	}
+
+	versions::iterator versions::find_newest(
+	    version_constraint const& query,
+	    StringSet const& architectures) const {
+		query_scratch scratch{};
+		return find_newest(
+		    query, arch_filter{architectures, symbols(), scratch.resource()});
+	}
+
+	versions::iterator versions::find_newest(
+	    version_constraint const& query,
+	    arch_filter const& architectures) const {
+		// first version above the upper bound, if there is one
+		auto it = std::partition_point(
+		    items.begin(), items.end(),
+		    [&](auto const& item) { return !query.above(item.first); });
+
+		while (it != items.begin()) {
+			--it;
+			if (query.below(it->first)) break;
+			if (query.stable_only() && !it->first.prerelease.empty()) continue;
+			if (provided_for(*it, architectures)) return it;
+		}
+
+		return items.end();
+	}
+
+	bool versions::provides(StringSet const& architectures) const noexcept {
+		if (architectures.empty()) return !packages.empty();
+
+		// no arch_filter here, it would allocate
+		return std::any_of(
+		    architectures.begin(), architectures.end(),
+		    [&](std::string const& name) {
+			    auto const arch = table.find(name);
+			    return arch && std::any_of(packages.begin(), packages.end(),
+			                               [&](package const& pkg) {
+				                               return pkg.arch == *arch;
+			                               });
+		    });
+	}
+
+	versions::resolution_table versions::resolve_all() const {
+		return resolve_all(any_architecture());
+	}
+
+	versions::resolution_table versions::resolve_all(
+	    StringSet const& architectures) const {
+		arch_filter const filter{architectures, table};
+		resolution_table result{};
+		result.parent_ = this;
+		// newest provider of each component seen so far, in the order the
+		// reverse walk of get_archives finds them: newer versions first,
+		// storage order inside a version
+		std::vector<package const*> carried{};
+		std::vector<package const*> next{};
+		symbol_set provided{};
 
-			auto pre = ':';
+		for (auto const& [ver, pkgs] : items) {
+			auto const first = result.packages_.size();
+
+			// only the first package of a component in a version provides
+			// it, and takes the place of the older provider
+			provided.clear();
+			next.clear();
 			for (auto const& pkg : pkgs) {
-				out << pre << ' ';
-				pre = ',';
-
-				if (pkg.selected)
-					out << (all_selected ? "\x1b[92m" : "\x1b[32m");
-				if (pkg.comp) {
-					out << pkg.comp->name;
-					if (pkg.comp->version)
-						out << '-' << pkg.comp->version->to_string();
-				} else {
-					out << "main";
-				}
-				if (pkg.selected) out << "\x1b[0m";
+				if (!filter.accepts(pkg.arch)) continue;
+				result.packages_.push_back(&pkg);
+				if (!pkg.comp || provided.contains(pkg.comp->name)) continue;
+				provided.insert(pkg.comp->name);
+				next.push_back(&pkg);
+			}
+			if (result.packages_.size() == first) continue;
+
+			for (auto const* pkg : carried) {
+				if (provided.contains(pkg->comp->name)) continue;
+				result.packages_.push_back(pkg);
+				next.push_back(pkg);
+			}
+			std::swap(carried, next);
+
+			result.rows_.push_back({&ver, first, result.packages_.size()});
+		}
+
+		return result;
+	}
 
-				if (diff_arch) out << " (" << pkg.arch << ')';
+	versions::resolution_table::row versions::resolution_table::operator[](
+	    size_t index) const noexcept {
+		auto const& entry = rows_[index];
+		return {*entry.version,
+		        std::span{packages_.data() + entry.first,
+		                  entry.last - entry.first},
+		        *parent_};
+	}
+
+	std::vector<fs::path> versions::resolution_table::row::archives() const {
+		std::vector<fs::path> result{};
+		result.reserve(packages.size());
+		for (auto const* pkg : packages)
+			result.push_back(parent.archive(*pkg));
+		return result;
+	}
+
+	void versions::comp_list::select(observer* obs) {
+		phase_timer timer{obs, phase::archives};
+		choose();
+	}
+
+	std::vector<fs::path> versions::comp_list::get_archives(observer* obs) {
+		phase_timer timer{obs, phase::archives};
+		choose();
+
+		std::vector<fs::path> archives{};
+		archives.reserve(chosen_.size());
+		for (auto const* pkg : chosen_)
+			archives.push_back(parent_->archive(*pkg));
+		return archives;
+	}
+
+	void versions::comp_list::choose() {
+		chosen_.clear();
+		missing_ = list_;
+
+		for (auto const& pkg : selected_->second) {
+			if (!architectures_.accepts(pkg.arch)) continue;
+			chosen_.push_back(&pkg);
+			if (pkg.comp) missing_.erase(pkg.comp->name);
+		}
+
+		if (!missing_.empty()) {
+			auto const below =
+			    static_cast<size_t>(selected_ - parent_->items.begin());
+			std::pmr::vector<component_provider> found{
+			    chosen_.get_allocator()};
+			found.reserve(missing_.size());
+			missing_.for_each([&](symbol comp) {
+				if (auto prov =
+				        parent_->newest_provider(comp, below, architectures_))
+					found.push_back(*prov);
+			});
+
+			// newer versions first, storage order inside a version
+			std::sort(found.begin(), found.end(),
+			          [](component_provider const& lhs,
+			             component_provider const& rhs) {
+				          if (lhs.version != rhs.version)
+					          return lhs.version > rhs.version;
+				          return lhs.package < rhs.package;
+			          });
+
+			for (auto const& prov : found) {
+				auto const& pkg = parent_->packages[prov.package];
+				chosen_.push_back(&pkg);
+				missing_.erase(pkg.comp->name);
 			}
-			out << '\n';
 		}
+	}
 
-		out << '\n';
+	bool versions::comp_list::selected(package const& pkg) const noexcept {
+		return std::find(chosen_.begin(), chosen_.end(), &pkg) !=
+		       chosen_.end();
 	}
 }  // namespace distro
@@ -0,0 +1,245 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "archive.hh"
+
+#include <optional>
+
+namespace distro {
+	namespace archive {
+		namespace {
+			constexpr std::uint32_t end_of_directory_sig = 0x06054b50;
+			constexpr std::uint32_t zip64_locator_sig = 0x07064b50;
+			constexpr std::uint32_t zip64_end_sig = 0x06064b50;
+			constexpr std::uint32_t central_sig = 0x02014b50;
+			constexpr std::uint32_t local_sig = 0x04034b50;
+
+			constexpr size_t end_of_directory_size = 22;
+			constexpr size_t zip64_locator_size = 20;
+			constexpr size_t zip64_end_size = 56;
+			constexpr size_t central_size = 46;
+			constexpr size_t local_size = 30;
+
+			constexpr std::uint16_t method_stored = 0;
+			constexpr std::uint16_t method_deflated = 8;
+			constexpr std::uint16_t flag_encrypted = 1;
+			// made by a host, which keeps st_mode in the external
+			// attributes
+			constexpr unsigned host_unix = 3;
+			constexpr std::uint32_t file_type_mask = 0170000;
+			constexpr std::uint32_t file_type_symlink = 0120000;
+
+			std::error_code damaged() {
+				return make_error_code(extract_errc::damaged_archive);
+			}
+
+			// little-endian fields of the records, bounds checked by the
+			// callers
+			template <typename Int>
+			Int read_le(std::string_view bytes, size_t offset) {
+				Int result{};
+				for (size_t index = sizeof(Int); index > 0; --index) {
+					result = static_cast<Int>(
+					    (result << 8) |
+					    static_cast<unsigned char>(bytes[offset + index - 1]));
+				}
+				return result;
+			}
+
+			struct directory_info {
+				std::uint64_t count{};
+				std::uint64_t offset{};
+				std::uint64_t size{};
+			};
+
+			struct central_entry {
+				std::uint16_t made_by{};
+				std::uint16_t flags{};
+				std::uint16_t method{};
+				std::uint32_t crc{};
+				std::uint64_t compressed{};
+				std::uint64_t size{};
+				std::uint32_t external{};
+				std::uint64_t local_offset{};
+				std::string_view name{};
+			};
+
+			std::optional<directory_info> find_directory(
+			    std::string_view bytes) {
+				if (bytes.size() < end_of_directory_size) return std::nullopt;
+
+				// the record ends with a comment of at most 64 KiB
+				auto pos = bytes.size() - end_of_directory_size;
+				auto const lowest =
+				    pos > 0xFFFF ? pos - 0xFFFF : size_t{};
+				while (read_le<std::uint32_t>(bytes, pos) !=
+				       end_of_directory_sig) {
+					if (pos == lowest) return std::nullopt;
+					--pos;
+				}
+
+				directory_info info{read_le<std::uint16_t>(bytes, pos + 10),
+				                    read_le<std::uint32_t>(bytes, pos + 16),
+				                    read_le<std::uint32_t>(bytes, pos + 12)};
+				if (info.count != 0xFFFF && info.offset != 0xFFFFFFFF &&
+				    info.size != 0xFFFFFFFF)
+					return info;
+
+				if (pos < zip64_locator_size) return std::nullopt;
+				auto const locator = pos - zip64_locator_size;
+				if (read_le<std::uint32_t>(bytes, locator) != zip64_locator_sig)
+					return std::nullopt;
+
+				auto const end = read_le<std::uint64_t>(bytes, locator + 8);
+				if (end > bytes.size() || bytes.size() - end < zip64_end_size ||
+				    read_le<std::uint32_t>(bytes, end) != zip64_end_sig)
+					return std::nullopt;
+
+				return directory_info{read_le<std::uint64_t>(bytes, end + 32),
+				                      read_le<std::uint64_t>(bytes, end + 48),
+				                      read_le<std::uint64_t>(bytes, end + 40)};
+			}
+
+			// the 32-bit fields set to all ones are in the zip64 extra
+			// field, in the order of the record
+			bool read_zip64(std::string_view extra,
+			                std::uint32_t size32,
+			                std::uint32_t compressed32,
+			                std::uint32_t offset32,
+			                central_entry& entry) {
+				while (extra.size() >= 4) {
+					auto const id = read_le<std::uint16_t>(extra, 0);
+					auto const length = read_le<std::uint16_t>(extra, 2);
+					if (extra.size() - 4 < length) return false;
+					auto data = extra.substr(4, length);
+					extra.remove_prefix(4u + length);
+					if (id != 1) continue;
+
+					auto const next = [&](std::uint64_t& value) {
+						if (data.size() < 8) return false;
+						value = read_le<std::uint64_t>(data, 0);
+						data.remove_prefix(8);
+						return true;
+					};
+					if (size32 == 0xFFFFFFFF && !next(entry.size))
+						return false;
+					if (compressed32 == 0xFFFFFFFF && !next(entry.compressed))
+						return false;
+					if (offset32 == 0xFFFFFFFF && !next(entry.local_offset))
+						return false;
+					return true;
+				}
+				return size32 != 0xFFFFFFFF && compressed32 != 0xFFFFFFFF &&
+				       offset32 != 0xFFFFFFFF;
+			}
+
+			std::error_code read_entry(std::string_view bytes,
+			                           central_entry const& entry,
+			                           entry_sink& sink) {
+				std::error_code ec{};
+				auto const path = safe_path(entry.name, ec);
+				if (ec) return ec;
+				if (path.empty()) return {};
+
+				if (entry.name.back() == '/' || entry.name.back() == '\\')
+					return sink.directory(path);
+
+				if (entry.flags & flag_encrypted ||
+				    (entry.method != method_stored &&
+				     entry.method != method_deflated))
+					return make_error_code(extract_errc::unsupported_entry);
+
+				// the local header repeats the name, but may have
+				// a different extra field
+				auto const local = entry.local_offset;
+				if (local > bytes.size() || bytes.size() - local < local_size ||
+				    read_le<std::uint32_t>(bytes, local) != local_sig)
+					return damaged();
+				auto const start = local + local_size +
+				                   read_le<std::uint16_t>(bytes, local + 26) +
+				                   read_le<std::uint16_t>(bytes, local + 28);
+				if (start > bytes.size() ||
+				    bytes.size() - start < entry.compressed)
+					return damaged();
+				auto const data = bytes.substr(
+				    static_cast<size_t>(start),
+				    static_cast<size_t>(entry.compressed));
+
+				auto const unix_host = (entry.made_by >> 8) == host_unix;
+				auto const st_mode = entry.external >> 16;
+				if (unix_host &&
+				    (st_mode & file_type_mask) == file_type_symlink) {
+					if (entry.method != method_stored) {
+						// targets are short enough to be stored by any
+						// sane tool
+						return make_error_code(
+						    extract_errc::unsupported_entry);
+					}
+					if (!safe_link(path, data))
+						return make_error_code(extract_errc::unsafe_path);
+					return sink.symlink(path, data);
+				}
+
+				auto const mode = unix_host ? st_mode & 07777 : 0;
+				if (auto err = sink.file_begin(path, mode)) return err;
+				if (entry.method == method_deflated) {
+					if (auto err = inflate(data, entry.size, entry.crc, sink))
+						return err;
+				} else {
+					std::uint32_t crc{};
+					if (data.size() != entry.size ||
+					    (archive::crc32(data, crc) && crc != entry.crc))
+						return damaged();
+					if (auto err = sink.file_data(data)) return err;
+				}
+				return sink.file_end();
+			}
+		}  // namespace
+
+		std::error_code read_zip(std::string_view bytes, entry_sink& sink) {
+			auto const dir = find_directory(bytes);
+			if (!dir || dir->offset > bytes.size() ||
+			    bytes.size() - dir->offset < dir->size)
+				return damaged();
+
+			auto records = bytes.substr(static_cast<size_t>(dir->offset),
+			                            static_cast<size_t>(dir->size));
+			for (std::uint64_t index = 0; index < dir->count; ++index) {
+				if (records.size() < central_size ||
+				    read_le<std::uint32_t>(records, 0) != central_sig)
+					return damaged();
+
+				central_entry entry{};
+				entry.made_by = read_le<std::uint16_t>(records, 4);
+				entry.flags = read_le<std::uint16_t>(records, 8);
+				entry.method = read_le<std::uint16_t>(records, 10);
+				entry.crc = read_le<std::uint32_t>(records, 16);
+				auto const compressed32 = read_le<std::uint32_t>(records, 20);
+				auto const size32 = read_le<std::uint32_t>(records, 24);
+				auto const name_size = read_le<std::uint16_t>(records, 28);
+				auto const extra_size = read_le<std::uint16_t>(records, 30);
+				auto const comment_size = read_le<std::uint16_t>(records, 32);
+				entry.external = read_le<std::uint32_t>(records, 38);
+				auto const offset32 = read_le<std::uint32_t>(records, 42);
+
+				auto const record_size =
+				    central_size + name_size + extra_size + comment_size;
+				if (records.size() < record_size) return damaged();
+				entry.name = records.substr(central_size, name_size);
+				entry.size = size32;
+				entry.compressed = compressed32;
+				entry.local_offset = offset32;
+				if (!read_zip64(
+				        records.substr(central_size + name_size, extra_size),
+				        size32, compressed32, offset32, entry))
+					return damaged();
+				records.remove_prefix(record_size);
+
+				if (entry.name.empty()) return damaged();
+				if (auto ec = read_entry(bytes, entry, sink)) return ec;
+			}
+			return {};
+		}
+	}  // namespace archive
+}  // namespace distro
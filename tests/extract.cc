@@ -0,0 +1,248 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/extract.hh>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.hh"
+
+using namespace std::literals;
+
+namespace {
+	namespace fs = std::filesystem;
+
+	struct entry {
+		char type;
+		std::string_view name;
+		// link target or file contents
+		std::string_view data{};
+	};
+
+	// ustar blocks of the entries, followed by the end of the archive
+	std::string tar_of(std::vector<entry> const& entries) {
+		std::string result{};
+		for (auto const& item : entries) {
+			std::array<char, 512> header{};
+			auto const put = [&](size_t offset, std::string_view text) {
+				std::copy(text.begin(), text.end(), header.begin() + offset);
+			};
+			auto const octal = [&](size_t offset, size_t length,
+			                       unsigned long value) {
+				std::snprintf(header.data() + offset, length, "%0*lo",
+				              static_cast<int>(length - 1), value);
+			};
+
+			auto const is_file = item.type == '0';
+			put(0, item.name);
+			octal(100, 8, 0644);
+			octal(108, 8, 0);
+			octal(116, 8, 0);
+			octal(124, 12, is_file ? item.data.size() : 0);
+			octal(136, 12, 0);
+			header[156] = item.type;
+			if (!is_file) put(157, item.data);
+			put(257, "ustar\0"sv);
+			put(263, "00"sv);
+
+			unsigned long checksum = 8 * ' ';
+			for (size_t index = 0; index < header.size(); ++index) {
+				if (index < 148 || index >= 156)
+					checksum += static_cast<unsigned char>(header[index]);
+			}
+			octal(148, 7, checksum);
+
+			result.append(header.data(), header.size());
+			if (is_file) {
+				result.append(item.data);
+				result.append((512 - item.data.size() % 512) % 512, '\0');
+			}
+		}
+		result.append(1024, '\0');
+		return result;
+	}
+
+	// The archive is unpacked into <dir>/out/dst; whatever it manages to
+	// put into <dir>/out got outside.
+	class sandbox {
+	public:
+		sandbox() { fs::create_directories(dst()); }
+
+		fs::path outside() const { return dir_.path() / "out"; }
+		fs::path dst() const { return outside() / "dst"; }
+
+		// error code dst_dir got, if any
+		std::error_code extract(std::vector<entry> const& entries) {
+			return extract_all({entries});
+		}
+
+		// one archive per list, the first ranked highest; with a single
+		// worker they are unpacked in the order of the list
+		std::error_code extract_all(
+		    std::vector<std::vector<entry>> const& lists,
+		    unsigned threads = 0) {
+			std::vector<fs::path> archives{};
+			for (auto const& entries : lists) {
+				auto const name =
+				    "archive-" + std::to_string(archives.size()) + ".tar";
+				archives.push_back(dir_.path() / name);
+				std::ofstream{archives.back(), std::ios::binary}
+				    << tar_of(entries);
+			}
+
+			tests::throwing_errors log{};
+			try {
+				distro::extract(archives, dst(), log, threads);
+			} catch (tests::reported const& report) {
+				return report.code;
+			}
+			return {};
+		}
+
+	private:
+		tests::temp_dir dir_{"distro-extract"};
+	};
+
+	std::string contents(fs::path const& path) {
+		std::ifstream in{path, std::ios::binary};
+		std::ostringstream out{};
+		out << in.rdbuf();
+		return out.str();
+	}
+
+	void links_inside() {
+		sandbox box{};
+		auto const ec = box.extract({
+		    {'5', "real/"},
+		    {'0', "real/file", "hello"},
+		    {'2', "current", "real"},
+		    {'2', "real/latest", "../current"},
+		    {'1', "copy", "real/file"},
+		});
+		tests::expect(!ec, "links staying inside are extracted");
+		tests::expect(contents(box.dst() / "current/file") == "hello",
+		              "link to a directory is followed");
+		tests::expect(contents(box.dst() / "real/latest/file") == "hello",
+		              "link to a link is followed");
+		tests::expect(contents(box.dst() / "copy") == "hello",
+		              "hard link is copied");
+	}
+
+	// The link, which breaks out, is lexically inside: the lookup of
+	// x goes through up, which is a link itself.
+	void chained_links() {
+		sandbox box{};
+		auto const ec = box.extract({
+		    {'2', "a/b/up", "../.."},
+		    {'2', "a/b/x", "up/.."},
+		    {'0', "a/b/x/pwned", "gotcha"},
+		});
+		tests::expect(ec == distro::extract_errc::unsafe_path,
+		              "link through a link is refused");
+		tests::expect(!fs::exists(box.outside() / "pwned"),
+		              "nothing written outside of the destination");
+	}
+
+	// Same, with the links coming in the other order.
+	void chained_links_reversed() {
+		sandbox box{};
+		auto const ec = box.extract({
+		    {'2', "a/b/x", "up/.."},
+		    {'2', "a/b/up", "../.."},
+		    {'0', "a/b/x/pwned", "gotcha"},
+		});
+		tests::expect(ec == distro::extract_errc::unsafe_path,
+		              "link on the way of another link is refused");
+		tests::expect(!fs::exists(box.outside() / "pwned"),
+		              "nothing written outside of the destination");
+	}
+
+	// up2 is lexically two levels down, but lands next to d, because
+	// it is created through up.
+	void written_through_link() {
+		sandbox box{};
+		auto const ec = box.extract({
+		    {'2', "d/up", ".."},
+		    {'2', "d/up/up2", ".."},
+		    {'0', "d/up/up2/pwned", "gotcha"},
+		});
+		tests::expect(ec == distro::extract_errc::unsafe_path,
+		              "entry inside a link is refused");
+		tests::expect(!fs::exists(box.dst() / "up2"),
+		              "nothing created through the link");
+		tests::expect(!fs::exists(box.outside() / "pwned"),
+		              "nothing written outside of the destination");
+	}
+
+	void link_from_before() {
+		sandbox box{};
+		fs::create_directory_symlink(box.outside(), box.dst() / "old");
+		auto const ec = box.extract({
+		    {'0', "old/pwned", "gotcha"},
+		});
+		tests::expect(ec == distro::extract_errc::unsafe_path,
+		              "entry inside an existing link is refused");
+		tests::expect(!fs::exists(box.outside() / "pwned"),
+		              "nothing written outside of the destination");
+	}
+
+	// The second archive is unpacked last, over the file of the first,
+	// which wins; its copy must still come from its own target.
+	void hard_link_to_covered() {
+		sandbox box{};
+		auto const ec = box.extract_all(
+		    {
+		        {
+		            {'0', "target", "first"},
+		        },
+		        {
+		            {'0', "target", "second"},
+		            {'1', "copy", "target"},
+		        },
+		    },
+		    1);
+		tests::expect(!ec, "both archives are extracted");
+		tests::expect(contents(box.dst() / "target") == "first",
+		              "archive listed first wins");
+		tests::expect(contents(box.dst() / "copy") == "second",
+		              "hard link copies the entry of its own archive");
+		auto leftovers = 0;
+		for (auto const& item : fs::directory_iterator{box.dst()}) {
+			auto const name = item.path().filename().string();
+			if (name != "target" && name != "copy") ++leftovers;
+		}
+		tests::expect(!leftovers, "no working copies left behind");
+	}
+
+	void hard_link_to_missing() {
+		sandbox box{};
+		std::ofstream{box.dst() / "target"} << "before";
+		auto const ec = box.extract({
+		    {'1', "copy", "target"},
+		});
+		tests::expect(ec == distro::extract_errc::damaged_archive,
+		              "hard link to an entry outside the archive is refused");
+		tests::expect(!fs::exists(box.dst() / "copy"),
+		              "nothing copied from the destination");
+	}
+}  // namespace
+
+int main() {
+	links_inside();
+	chained_links();
+	chained_links_reversed();
+	written_through_link();
+	link_from_before();
+	hard_link_to_covered();
+	hard_link_to_missing();
+	return tests::result();
+}
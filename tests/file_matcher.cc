@@ -0,0 +1,129 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/file_matcher.hh>
+#include <distro/package.hh>
+#include <distro/regex.hh>
+
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.hh"
+
+using namespace std::literals;
+
+namespace {
+	constexpr auto package_name = "libdistro"sv;
+
+	// platforms sharing prefixes and extensions sharing suffixes, so that
+	// both tries have to back off and try the next candidate; with
+	// "ubuntu18-lts" also read as "ubuntu18" and the "lts" component,
+	// the order of the platforms decides the captures
+	std::vector<std::string_view> const platforms = {
+	    "windows-x86_64", "windows-x86", "windows",     "ubuntu18-x86_64",
+	    "ubuntu18",       "anywhere",    "ubuntu18-lts"};
+	std::vector<std::string_view> const extensions = {"tar.gz", "gz", "zip",
+	                                                  "tar", "tar.xz"};
+
+	// pieces of the filenames, valid or nearly so
+	constexpr std::string_view names[] = {
+	    "libdistro", "libdistr", "libdistro-", "libdistrox", "xlibdistro", ""};
+	constexpr std::string_view versions[] = {
+	    "1.2.3",   "1.0",     "1",     "1.2.3-rc.1", "1.2.3-rc-1", "0.0.0",
+	    "1..2",    "1.2.3-",  "a.b.c", "",           "1.2.3-x86",  "01.2.3",
+	    "1.2.3-a", "1.2.3.4", "1-2",   "1.2.3-."};
+	constexpr std::string_view architectures[] = {
+	    "windows-x86_64", "windows-x86", "windows",  "windows-x86_32",
+	    "ubuntu18",       "ubuntu18-x86_64", "anywhere", "windows-",
+	    "",               "linux",           "ubuntu18-lts"};
+	constexpr std::string_view components[] = {
+	    "",     "-dev",     "-dev-1.2", "-dev-",  "-dev-1.a", "-x86_64",
+	    "-d3v", "-dev-1.2-", "-",       "-Dev-0", "-dev-dev", "-a-1",
+	    "-lts", "-lts-2.0"};
+	constexpr std::string_view suffixes[] = {
+	    ".tar.gz", ".gz",  ".zip", ".tar", ".tar.xz", ".xz", ".tar.",
+	    "",        ".zip.", "zip", ".TAR", ".tar.gz.zip"};
+
+	template <typename Pieces>
+	std::string_view any(Pieces const& pieces, std::mt19937& rng) {
+		return pieces[rng() % std::size(pieces)];
+	}
+
+	// Random joins of the pieces, mostly with the right package name,
+	// half of them with one character replaced, inserted or removed.
+	std::vector<std::string> filenames(size_t count) {
+		static constexpr auto alphabet = "0123456789.-_abdgrtxz"sv;
+
+		std::mt19937 rng{2021};
+		auto const pick = [&] { return alphabet[rng() % alphabet.size()]; };
+
+		std::vector<std::string> result{};
+		result.reserve(count);
+		for (size_t index = 0; index < count; ++index) {
+			auto const name = index % 4 ? package_name : any(names, rng);
+			auto str = std::string{name} + '-' +
+			           std::string{any(versions, rng)} + '-' +
+			           std::string{any(architectures, rng)} +
+			           std::string{any(components, rng)} +
+			           std::string{any(suffixes, rng)};
+			if (index % 2) {
+				auto const pos = rng() % (str.size() + 1);
+				switch (rng() % 3) {
+					case 0:
+						if (pos < str.size()) str[pos] = pick();
+						break;
+					case 1:
+						str.insert(str.begin() + static_cast<ptrdiff_t>(pos),
+						           pick());
+						break;
+					default:
+						if (pos < str.size())
+							str.erase(str.begin() +
+							          static_cast<ptrdiff_t>(pos));
+						break;
+				}
+			}
+			result.push_back(std::move(str));
+		}
+		return result;
+	}
+
+	bool same(std::optional<distro::file_match> const& lhs,
+	          std::optional<distro::file_match> const& rhs) {
+		if (!lhs || !rhs) return !lhs == !rhs;
+		return lhs->version == rhs->version && lhs->arch == rhs->arch &&
+		       lhs->comp == rhs->comp && lhs->compver == rhs->compver;
+	}
+
+	// file_matcher has to accept exactly the filenames the regex of
+	// build_file_matcher accepts, with the same captures.
+	void same_as_regex() {
+		auto const regex =
+		    distro::build_file_matcher(package_name, platforms, extensions);
+		distro::file_matcher const matcher{package_name, platforms,
+		                                   extensions};
+
+		auto const inputs = filenames(40'000);
+		size_t accepted{};
+		for (auto const& filename : inputs) {
+			auto const expected = distro::package::match(filename, regex);
+			auto const actual = distro::package::match(filename, matcher);
+			tests::expect(same(expected, actual),
+			              "matched \"" + filename + '"');
+			if (expected) ++accepted;
+		}
+
+		// the noise should not drown the matching names
+		tests::expect(accepted > inputs.size() / 100,
+		              "enough of the names match");
+	}
+}  // namespace
+
+int main() {
+	same_as_regex();
+	return tests::result();
+}
@@ -0,0 +1,57 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "helpers.hh"
+
+#include <distro/semver.hh>
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+
+namespace tests {
+	namespace {
+		std::atomic<unsigned> failures{0};
+	}  // namespace
+
+	void expect(bool condition,
+	            std::string_view what,
+	            std::source_location where) {
+		if (condition) return;
+		++failures;
+		std::fprintf(stderr, "%s:%lu: expectation failed: %.*s\n",
+		             where.file_name(),
+		             static_cast<unsigned long>(where.line()),
+		             static_cast<int>(what.size()), what.data());
+	}
+
+	int result() noexcept { return failures.load() ? 1 : 0; }
+
+	void throwing_errors::src_dir(std::error_code const& ec) const {
+		throw reported{"src_dir: " + ec.message(), ec};
+	}
+
+	void throwing_errors::dst_dir(std::error_code const& ec) const {
+		throw reported{"dst_dir: " + ec.message(), ec};
+	}
+
+	void throwing_errors::version_missing(
+	    distro::semver const& missing) const {
+		throw reported{"version_missing: " + missing.to_string()};
+	}
+
+	temp_dir::temp_dir(std::string const& prefix) {
+		std::random_device rd{};
+		auto const base = fs::temp_directory_path();
+		while (true) {
+			path_ = base / (prefix + '-' + std::to_string(rd()));
+			if (fs::create_directories(path_)) break;
+		}
+	}
+
+	temp_dir::~temp_dir() {
+		std::error_code ignore{};
+		fs::remove_all(path_, ignore);
+	}
+}  // namespace tests
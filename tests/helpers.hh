@@ -0,0 +1,58 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <distro/errors.hh>
+
+#include <filesystem>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace tests {
+	namespace fs = std::filesystem;
+
+	// Prints the failed expectations; a test's main returns result(),
+	// which is non-zero, if any of them failed. Safe to call from any
+	// thread.
+	void expect(
+	    bool condition,
+	    std::string_view what,
+	    std::source_location where = std::source_location::current());
+	int result() noexcept;
+
+	// turns each of the reports into an exception, so that a test can
+	// expect it, or fail on it
+	struct throwing_errors : distro::errors {
+		[[noreturn]] void src_dir(std::error_code const& ec) const override;
+		[[noreturn]] void dst_dir(std::error_code const& ec) const override;
+		[[noreturn]] void version_missing(
+		    distro::semver const& missing) const override;
+	};
+
+	struct reported : std::runtime_error {
+		reported(std::string const& what, std::error_code code = {})
+		    : std::runtime_error{what}, code{code} {}
+
+		std::error_code code;
+	};
+
+	// fresh directory inside the temporary directory, removed with
+	// everything inside it on destruction
+	class temp_dir {
+	public:
+		explicit temp_dir(std::string const& prefix);
+		~temp_dir();
+		temp_dir(temp_dir const&) = delete;
+		temp_dir& operator=(temp_dir const&) = delete;
+
+		fs::path const& path() const noexcept { return path_; }
+
+	private:
+		fs::path path_;
+	};
+}  // namespace tests
@@ -0,0 +1,98 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/regex.hh>
+
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.hh"
+
+using namespace std::literals;
+
+namespace {
+	struct pattern {
+		std::string_view name;
+		std::vector<std::string_view> extensions;
+		// names the regex reads the package name as, the name itself first
+		std::vector<std::string_view> spellings;
+		// extensions the regex reads the list as
+		std::vector<std::string_view> suffixes;
+	};
+
+	std::vector<pattern> const patterns = {
+	    {"libdistro", {"zip", "tar.gz"}, {"libdistro", "libdistr"},
+	     {"zip", "tar.gz", "tarxgz", "gz"}},
+	    {"lib.net", {"zip"}, {"lib.net", "libxnet", "lib-net"}, {"zip"}},
+	    {"c+", {"zip"}, {"c+", "c", "cc", "ccc"}, {"zip"}},
+	    {"a[bc]", {"zip"}, {"a[bc]", "ab", "ac"}, {"zip"}},
+	    {"pkg", {"tar.x?z"}, {"pkg"}, {"tar.x?z", "tar.z", "tar.xz"}},
+	    {"(ab|cd)", {"zip"}, {"(ab|cd)", "ab", "cd"}, {"zip"}},
+	};
+
+	std::vector<std::string_view> const versions = {
+	    "1", "1.2.3", "1.2.3-rc.1", "", "x"};
+	std::vector<std::string_view> const platforms = {
+	    "windows-x86_64", "anywhere", "linux"};
+	std::vector<std::string_view> const components = {"", "-dev", "-dev-1.2"};
+
+	// every name the regex accepts must pass the prefilter, if there is
+	// one; names it turns down are not checked
+	void no_false_rejects(pattern const& pat) {
+		auto const matcher =
+		    distro::build_file_matcher(pat.name, platforms, pat.extensions);
+		auto const& prefilter = matcher.prefilter();
+
+		size_t matched{};
+		for (auto spelling : pat.spellings) {
+			for (auto version : versions) {
+				for (auto platform : platforms) {
+					for (auto comp : components) {
+						for (auto suffix : pat.suffixes) {
+							auto const filename =
+							    std::string{spelling} + '-' +
+							    std::string{version} + '-' +
+							    std::string{platform} + std::string{comp} +
+							    '.' + std::string{suffix};
+							if (!std::regex_search(filename, matcher))
+								continue;
+							++matched;
+							tests::expect(!prefilter ||
+							                  prefilter->accepts(filename),
+							              filename);
+						}
+					}
+				}
+			}
+		}
+		tests::expect(matched > 0, pat.name);
+	}
+
+	void literal_names_keep_the_prefilter() {
+		tests::expect(
+		    distro::build_file_matcher("libdistro", platforms, {"tar.gz"})
+		        .prefilter()
+		        .has_value(),
+		    "plain name and dotted extension are prefiltered");
+		tests::expect(
+		    !distro::build_file_matcher("lib.net", platforms, {"zip"})
+		         .prefilter()
+		         .has_value(),
+		    "name with a regex dot is not prefiltered");
+		tests::expect(
+		    !distro::build_file_matcher("pkg", platforms, {"tar.x?z"})
+		         .prefilter()
+		         .has_value(),
+		    "extension with a regex quantifier is not prefiltered");
+	}
+}  // namespace
+
+int main() {
+	for (auto const& pat : patterns)
+		no_false_rejects(pat);
+	literal_names_keep_the_prefilter();
+	return tests::result();
+}
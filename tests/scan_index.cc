@@ -0,0 +1,93 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/file_matcher.hh>
+#include <distro/regex.hh>
+#include <distro/versions.hh>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.hh"
+
+using namespace std::literals;
+
+namespace {
+	namespace fs = std::filesystem;
+
+	// every field of every package, in the order of the set
+	std::string dump(distro::versions const& set) {
+		std::string result{};
+		for (auto const& [version, run] : set) {
+			result += version.to_string() + ":\n";
+			for (auto const& pkg : run) {
+				result += "  " + std::string{pkg.filename} + ' ' +
+				          pkg.version.to_string() + ' ' +
+				          std::string{set.name(pkg.arch)};
+				if (pkg.comp) {
+					result += ' ';
+					result += set.name(pkg.comp->name);
+					if (pkg.comp->version)
+						result += ' ' + pkg.comp->version->to_string();
+				}
+				result += '\n';
+			}
+		}
+		return result;
+	}
+
+	// A warm read_cached has to give the same packages as a scan, with
+	// every field coming from the index instead of the names.
+	void same_as_scan() {
+		tests::temp_dir dir{"distro-index"};
+		auto const srcdir = dir.path() / "archives";
+		auto const index_file = dir.path() / "index";
+		fs::create_directories(srcdir);
+		for (auto name : {
+		         "my-app-1.0.0-anywhere.zip"sv,
+		         "my-app-1.0.0-windows-x86_64-tools.zip"sv,
+		         "my-app-1.2.0-rc.1-anywhere-doc-2.0.1.zip"sv,
+		         "my-app-1.2.0-rc.1-ubuntu18-x86_64.tar.gz"sv,
+		         "my-app-1.2.0-alpha.beta.7-anywhere.zip"sv,
+		         "my-app-1.2.0-0.3-anywhere-sdk-1.0-x.tar.gz"sv,
+		         "my-app-2.0.0-windows-x86_32-sdk-3.1.4.zip"sv,
+		         "other-app-2.0.0-anywhere.zip"sv,
+		         "my-app-2.0.0-anywhere.txt"sv,
+		     }) {
+			std::ofstream{srcdir / name};
+		}
+		// only directories, which settled down, get an index
+		fs::last_write_time(
+		    srcdir, fs::file_time_type::clock::now() - std::chrono::hours{1});
+
+		std::vector<std::string_view> const extensions{"zip", "tar.gz"};
+		distro::file_matcher const matcher{
+		    "my-app"sv, distro::regex::platforms(), extensions};
+		tests::throwing_errors const log{};
+
+		for (auto const& archs : {distro::StringSet{},
+		                          distro::StringSet{"anywhere"}}) {
+			auto const scanned =
+			    distro::versions::read_packages(srcdir, archs, matcher, log);
+			auto const cold = distro::versions::read_cached(
+			    srcdir, index_file, archs, matcher, log);
+			tests::expect(fs::exists(index_file), "index is written");
+			auto const warm = distro::versions::read_cached(
+			    srcdir, index_file, archs, matcher, log);
+
+			auto const expected = dump(scanned);
+			tests::expect(!scanned.empty(), "the scan finds packages");
+			tests::expect(dump(cold) == expected, "cold read is a scan");
+			tests::expect(dump(warm) == expected, "warm read is a scan");
+		}
+	}
+}  // namespace
+
+int main() {
+	same_as_scan();
+	return tests::result();
+}
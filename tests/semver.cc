@@ -0,0 +1,183 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/semver.hh>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.hh"
+#include "semver_regex.hh"
+
+using namespace std::literals;
+
+namespace {
+	// Hand-picked edge cases: leading zeros, empty identifiers, overflow,
+	// numeric-looking strings, stray separators and bytes outside ASCII.
+	std::vector<std::string> edge_cases() {
+		return {"",
+		        "1",
+		        "1.2",
+		        "1.2.3",
+		        "0.0.0",
+		        "01.2.3",
+		        "1.02.3",
+		        "1.2.03",
+		        "1.2.3-",
+		        "1.2.3+",
+		        "1.2.3-+",
+		        "1.2.3-0",
+		        "1.2.3-00",
+		        "1.2.3-01",
+		        "1.2.3-0a",
+		        "1.2.3-00a",
+		        "1.2.3-a.0",
+		        "1.2.3-a..b",
+		        "1.2.3-a.",
+		        "1.2.3-.a",
+		        "1.2.3--",
+		        "1.2.3---a",
+		        "1.2.3-alpha.1+build.7",
+		        "1.2.3+build",
+		        "1.2.3+007",
+		        "1.2.3+0",
+		        "1.2.3+a..b",
+		        "1.2.3+a+b",
+		        "1.2.3-rc.1-x",
+		        "1.2.3-a_b",
+		        "1.2.3 ",
+		        " 1.2.3",
+		        "1.2.3\n",
+		        "1..3",
+		        ".1.2.3",
+		        "4294967295.0.0",
+		        "4294967296.0.0",
+		        "99999999999999999999.1.1",
+		        "1.2.3-4294967296",
+		        "1.2.3-99999999999999999999",
+		        "1.2.3-\xc3\xa9",
+		        "1.2.3+\xff"};
+	}
+
+	// Random strings over the characters versions are made of, and
+	// valid versions with one character replaced, inserted or removed.
+	std::vector<std::string> mutated(size_t count) {
+		static constexpr auto alphabet = "0123456789.-+aZx"sv;
+		static constexpr std::string_view valid[] = {
+		    "1.2.3",          "0.0.0",         "10.20.30",
+		    "1.2.3-alpha",    "1.2.3-alpha.1", "1.2.3-0.3.7",
+		    "1.2.3-rc.1+b.2", "1.0.0+20130313", "1.2.3-x-y-z.--"};
+
+		std::mt19937 rng{2021};
+		auto const pick = [&] { return alphabet[rng() % alphabet.size()]; };
+
+		std::vector<std::string> result{};
+		result.reserve(count);
+		for (size_t index = 0; index < count; ++index) {
+			if (index % 2) {
+				std::string str(rng() % 16, ' ');
+				for (auto& c : str)
+					c = pick();
+				result.push_back(std::move(str));
+				continue;
+			}
+
+			std::string str{valid[rng() % std::size(valid)]};
+			auto const pos = rng() % (str.size() + 1);
+			switch (rng() % 3) {
+				case 0:
+					if (pos < str.size()) str[pos] = pick();
+					break;
+				case 1:
+					str.insert(str.begin() + static_cast<ptrdiff_t>(pos),
+					           pick());
+					break;
+				default:
+					if (pos < str.size())
+						str.erase(str.begin() + static_cast<ptrdiff_t>(pos));
+					break;
+			}
+			result.push_back(std::move(str));
+		}
+		return result;
+	}
+
+	bool same(std::optional<distro::semver> const& lhs,
+	          std::optional<distro::semver> const& rhs) {
+		if (!lhs || !rhs) return !lhs == !rhs;
+		// operator== ignores the meta, and the comps compare equal only
+		// with the same kind of value
+		return *lhs == *rhs && lhs->meta == rhs->meta &&
+		       lhs->to_string() == rhs->to_string();
+	}
+
+	// semver::from_string has to accept exactly what the old regex
+	// parser accepted, with the same fields.
+	void same_as_regex() {
+		auto inputs = edge_cases();
+		auto const more = mutated(50'000);
+		inputs.insert(inputs.end(), more.begin(), more.end());
+
+		size_t accepted{};
+		std::optional<distro::semver> previous{};
+		for (auto const& input : inputs) {
+			auto const expected = tests::semver_from_regex(input);
+			auto const actual = distro::semver::from_string(input);
+			tests::expect(same(expected, actual), "parsed \"" + input + '"');
+			if (!expected || !actual) continue;
+			++accepted;
+
+			// the sort keys have to agree with the fields, too
+			if (previous) {
+				tests::expect(
+				    (*previous < *actual) == (*previous < *expected) &&
+				        (*actual < *previous) == (*expected < *previous),
+				    "ordered \"" + input + '"');
+			}
+			previous = actual;
+		}
+
+		// the mutations should not drown the valid versions
+		tests::expect(accepted > inputs.size() / 10,
+		              "enough of the inputs are versions");
+	}
+
+	// The fields stay public; changing them without update_key must not
+	// leave the comparisons on the stale key.
+	void changed_fields() {
+		auto const parse = [](std::string_view view) {
+			return *distro::semver::from_string(view);
+		};
+
+		auto version = parse("1.2.3");
+		version.patch = 5;
+		tests::expect(parse("1.2.4") < version, "changed patch is compared");
+		version.major = 1u << 22;
+		tests::expect(parse("2.0.0") < version,
+		              "major too big for the key is compared");
+
+		version = parse("1.2.3");
+		version.prerelease.emplace_back("alpha");
+		tests::expect(version < parse("1.2.3"),
+		              "added prerelease is compared");
+		tests::expect(parse("1.2.3-alpha") == version,
+		              "added prerelease equals the parsed one");
+
+		version = parse("1.2.3-alpha.1");
+		version.prerelease.pop_back();
+		tests::expect(parse("1.2.3-alpha") == version,
+		              "shortened prerelease equals the parsed one");
+		version.prerelease.clear();
+		tests::expect(parse("1.2.3-alpha") < version,
+		              "removed prerelease is compared");
+	}
+}  // namespace
+
+int main() {
+	same_as_regex();
+	changed_fields();
+	return tests::result();
+}
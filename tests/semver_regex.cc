@@ -0,0 +1,90 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include "semver_regex.hh"
+
+#include <distro/regex.hh>
+
+#include <cctype>
+#include <charconv>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace tests {
+	namespace {
+		auto const semvercomp_pattern = std::regex{
+		    "^0|[1-9]\\d*$", std::regex::ECMAScript | std::regex::optimize};
+		auto const semver_pattern = std::regex{
+		    "^(0|[1-9]\\d*)\\.(0|[1-9]\\d*)\\.(0|[1-9]\\d*)(?:-((?:0|[1-9]\\d*|"
+		    "\\d*[a-zA-Z-][0-9a-zA-Z-]*)(?:\\.(?:0|[1-9]\\d*|\\d*[a-zA-Z-][0-9"
+		    "a-zA-Z-]*))*))?(?:\\+([0-9a-zA-Z-]+(?:\\.[0-9a-zA-Z-]+)*))?$",
+		    std::regex::ECMAScript | std::regex::optimize};
+
+		unsigned to_unsigned(std::string_view in) {
+			unsigned result{};
+			(void)std::from_chars(in.data(), in.data() + in.size(), result);
+			return result;
+		}
+
+		distro::semver::comp comp_from_string(std::string_view view) {
+			if (std::regex_match(view.begin(), view.end(), semvercomp_pattern))
+				return to_unsigned(view);
+			return view;
+		}
+
+		std::optional<std::vector<std::string>> split_identifiers(
+		    distro::svsub_match const& capture) {
+			if (!capture.matched) return std::vector<std::string>{};
+
+			auto chunks = distro::to_view(capture);
+			size_t prev = 0, curr = 0, end = chunks.size();
+			std::optional<std::vector<std::string>> result{
+			    std::vector<std::string>{}};
+
+			while (curr != end) {
+				auto const c = static_cast<unsigned char>(chunks[curr]);
+				if (c == '.') {
+					if (prev == curr) return std::nullopt;
+					if (chunks[prev] == '0' && (curr - prev) > 1)
+						return std::nullopt;
+
+					result->emplace_back(chunks.data() + prev,
+					                     chunks.data() + curr);
+					++curr;
+					prev = curr;
+					continue;
+				}
+
+				if (!std::isalnum(c) && c != '-') return std::nullopt;
+				++curr;
+			}
+			if (prev == curr) return std::nullopt;
+			if (chunks[prev] == '0' && (curr - prev) > 1) return std::nullopt;
+
+			result->emplace_back(chunks.data() + prev, chunks.data() + curr);
+			return result;
+		}
+	}  // namespace
+
+	std::optional<distro::semver> semver_from_regex(std::string_view view) {
+		distro::svmatch match{};
+		if (!std::regex_match(view.begin(), view.end(), match, semver_pattern))
+			return std::nullopt;
+
+		auto prerel_strings = split_identifiers(match[4]);
+		auto meta_strings = split_identifiers(match[5]);
+		if (!prerel_strings || !meta_strings) return std::nullopt;
+
+		distro::semver result{to_unsigned(distro::to_view(match[1])),
+		                      to_unsigned(distro::to_view(match[2])),
+		                      to_unsigned(distro::to_view(match[3]))};
+		for (auto const& str : *prerel_strings)
+			result.prerelease.push_back(comp_from_string(str));
+		for (auto const& str : *meta_strings)
+			result.meta.emplace_back(str);
+		result.update_key();
+		return result;
+	}
+}  // namespace tests
@@ -0,0 +1,17 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <distro/semver.hh>
+
+#include <optional>
+#include <string_view>
+
+namespace tests {
+	// The std::regex parser semver::from_string used to be, kept as the
+	// reference for the differential test and the benchmark. Accepts and
+	// fills the same versions, only slower.
+	std::optional<distro::semver> semver_from_regex(std::string_view view);
+}  // namespace tests
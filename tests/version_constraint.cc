@@ -0,0 +1,141 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/version_constraint.hh>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "helpers.hh"
+
+using namespace std::literals;
+
+namespace {
+	struct contains_case {
+		std::string_view constraint;
+		std::string_view version;
+		bool expected;
+	};
+
+	// each operator with full and partial versions, at the edges of the
+	// interval and with prereleases right below them
+	std::vector<contains_case> const contains_cases = {
+	    // exact, or the newest of the prereleases, if missing
+	    {"1.2.3", "1.2.3", true},
+	    {"1.2.3", "1.2.3-rc.1", true},
+	    {"1.2.3", "1.2.2", false},
+	    {"1.2.3", "1.2.4-alpha", false},
+	    {"=1.2.3-rc.1", "1.2.3-rc.1", true},
+	    {"=1.2.3-rc.1", "1.2.3-rc.2", false},
+	    {"=1.2.3-rc.1", "1.2.3", false},
+	    // partial: any version starting with the parts
+	    {"1.2", "1.2.0-alpha", true},
+	    {"1.2", "1.2.0", true},
+	    {"1.2", "1.2.99", true},
+	    {"1.2", "1.1.99", false},
+	    {"1.2", "1.3.0-alpha", false},
+	    {"=1", "1.0.0-alpha", true},
+	    {"=1", "1.99.0", true},
+	    {"=1", "0.99.0", false},
+	    {"=1", "2.0.0-alpha", false},
+	    {"1.x", "1.0.0-alpha", true},
+	    {"1.x", "2.0.0", false},
+	    // caret
+	    {"^1.2.3", "1.2.3", true},
+	    {"^1.2.3", "1.2.3-alpha", false},
+	    {"^1.2.3", "1.99.0", true},
+	    {"^1.2.3", "2.0.0-alpha", false},
+	    {"^1.2", "1.2.0-alpha", true},
+	    {"^1.2", "1.1.99", false},
+	    {"^1.2", "1.99.0", true},
+	    {"^1.2", "2.0.0-alpha", false},
+	    {"^1", "1.0.0-alpha", true},
+	    {"^1", "2.0.0", false},
+	    {"^0.2.3", "0.2.9", true},
+	    {"^0.2.3", "0.3.0-alpha", false},
+	    {"^0.0.3", "0.0.3", true},
+	    {"^0.0.3", "0.0.4-alpha", false},
+	    {"^0.2", "0.2.0-alpha", true},
+	    {"^0.2", "0.3.0", false},
+	    // tilde
+	    {"~1.2.3", "1.2.3", true},
+	    {"~1.2.3", "1.2.3-alpha", false},
+	    {"~1.2.3", "1.2.99", true},
+	    {"~1.2.3", "1.3.0-alpha", false},
+	    {"~1.2", "1.2.0-alpha", true},
+	    {"~1.2", "1.2.99", true},
+	    {"~1.2", "1.3.0-alpha", false},
+	    {"~1", "1.0.0-alpha", true},
+	    {"~1", "1.99.0", true},
+	    {"~1", "2.0.0-alpha", false},
+	    // comparisons
+	    {">=1.2.3", "1.2.3", true},
+	    {">=1.2.3", "1.2.3-alpha", false},
+	    {">=1.2", "1.2.0-alpha", true},
+	    {">=1.2", "1.1.99", false},
+	    {">=1", "1.0.0-alpha", true},
+	    {">=1", "0.99.0", false},
+	    {">1.2.3", "1.2.3", false},
+	    {">1.2.3", "1.2.4-alpha", true},
+	    {">1.2", "1.2.99", false},
+	    {">1.2", "1.3.0-alpha", true},
+	    {">1", "1.99.0", false},
+	    {">1", "2.0.0-alpha", true},
+	    {"<1.2.3", "1.2.3-alpha", true},
+	    {"<1.2.3", "1.2.3", false},
+	    {"<1.2", "1.1.99", true},
+	    {"<1.2", "1.2.0-alpha", false},
+	    {"<2", "1.99.0", true},
+	    {"<2", "2.0.0-alpha", false},
+	    {"<=1.2.3", "1.2.3", true},
+	    {"<=1.2.3", "1.2.4-alpha", false},
+	    {"<=1.2", "1.2.99", true},
+	    {"<=1.2", "1.3.0-alpha", false},
+	    {"<=1", "1.99.0", true},
+	    {"<=1", "2.0.0-alpha", false},
+	    // several terms, stable and anything
+	    {">=1.2 <2", "1.2.0-alpha", true},
+	    {">=1.2 <2 stable", "1.2.0-alpha", false},
+	    {">=1.2 <2 stable", "1.5.0", true},
+	    {"^1.2 ~1.4", "1.4.0-alpha", true},
+	    {"^1.2 ~1.4", "1.5.0", false},
+	    {"stable", "1.0.0-rc.1", false},
+	    {"stable", "1.0.0", true},
+	    {"*", "0.0.1-alpha", true},
+	    {"", "0.0.1-alpha", true},
+	};
+
+	std::vector<std::string_view> const invalid = {
+	    "1.x.2", "abc", ">=", "^", "1.2.3.4", "1..2", "~-1",
+	};
+
+	void contains() {
+		for (auto const& [constraint, version, expected] : contains_cases) {
+			auto const what = "\""s + std::string{constraint} + "\" on " +
+			                  std::string{version};
+			auto const parsed =
+			    distro::version_constraint::from_string(constraint);
+			auto const ver = distro::semver::from_string(version);
+			tests::expect(parsed.has_value() && ver.has_value(),
+			              what + " parses");
+			if (!parsed || !ver) continue;
+			tests::expect(parsed->contains(*ver) == expected, what);
+		}
+	}
+
+	void rejects_invalid() {
+		for (auto constraint : invalid) {
+			tests::expect(
+			    !distro::version_constraint::from_string(constraint),
+			    constraint);
+		}
+	}
+}  // namespace
+
+int main() {
+	contains();
+	rejects_invalid();
+	return tests::result();
+}
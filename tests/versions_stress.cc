@@ -0,0 +1,182 @@
+// Copyright 2021 midnightBITS
+// Use of this source code is governed by a MIT-style license that can be
+// found in the LICENSE file.
+
+#include <distro/file_matcher.hh>
+#include <distro/regex.hh>
+#include <distro/versions.hh>
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "helpers.hh"
+
+using namespace std::literals;
+
+namespace {
+	constexpr auto package_name = "my-app"sv;
+
+	// Releases of package_name: main archives for some of the platforms,
+	// components only now and then, so most of the queries take
+	// providers from older versions, and some prereleases. The names go
+	// to a manifest, so the scan does not need any real archives.
+	std::string manifest_text() {
+		static constexpr std::string_view platforms[] = {
+		    "windows-x86_64", "ubuntu18-x86_64", "anywhere"};
+		static constexpr std::string_view components[] = {"doc", "tools",
+		                                                  "sdk"};
+		static constexpr std::string_view prereleases[] = {"alpha", "beta.2",
+		                                                   "rc.1"};
+
+		std::mt19937 rng{2021};
+		std::string result{};
+		for (unsigned major = 0; major < 4; ++major) {
+			for (unsigned minor = 0; minor < 5; ++minor) {
+				for (unsigned patch = 0; patch < 4; ++patch) {
+					auto version = std::to_string(major) + '.' +
+					               std::to_string(minor) + '.' +
+					               std::to_string(patch);
+					if (rng() % 5 == 0) {
+						version += '-';
+						version += prereleases[rng() % std::size(prereleases)];
+					}
+
+					for (auto platform : platforms) {
+						if (rng() % 3 == 0) continue;
+						auto const base = std::string{package_name} + '-' +
+						                  version + '-' + std::string{platform};
+						result += base + ".zip\n";
+						for (auto comp : components) {
+							if (rng() % 4) continue;
+							result += base + '-';
+							result += comp;
+							result += ".tar.gz\n";
+						}
+					}
+				}
+			}
+		}
+		return result;
+	}
+
+	struct query {
+		distro::semver version;
+		distro::StringSet architectures;
+	};
+
+	// what one thread saw for a query; an empty report stands for
+	// a version not available for the architectures
+	struct answer {
+		std::vector<std::filesystem::path> archives{};
+		std::string report{};
+
+		bool operator==(answer const&) const = default;
+	};
+
+	answer resolve(distro::versions const& set, query const& q) {
+		tests::throwing_errors log{};
+		std::optional<distro::semver> requested = q.version;
+		try {
+			auto const selected =
+			    set.find_selected(requested, log, q.architectures);
+			auto comps = set.components(selected, q.architectures);
+			answer result{};
+			result.archives = comps.get_archives();
+			comps.report(distro::report_format::json, result.report);
+			return result;
+		} catch (tests::reported const&) {
+			return {};
+		}
+	}
+
+	std::vector<std::vector<std::filesystem::path>> resolve_all(
+	    distro::versions const& set,
+	    distro::StringSet const& architectures) {
+		auto const table = set.resolve_all(architectures);
+		std::vector<std::vector<std::filesystem::path>> result{};
+		result.reserve(table.size());
+		for (size_t index = 0; index < table.size(); ++index)
+			result.push_back(table[index].archives());
+		return result;
+	}
+
+	// One set, read once, resolved for every version and some of the
+	// architecture sets from many threads at once. Every answer must be
+	// the same as the one given to a single thread.
+	void shared_between_threads() {
+		tests::temp_dir dir{"distro-stress"};
+		auto const manifest = dir.path() / "MANIFEST";
+		std::ofstream{manifest} << manifest_text();
+
+		std::vector<std::string_view> const extensions{"zip", "tar.gz"};
+		distro::file_matcher const matcher{
+		    package_name, distro::regex::platforms(), extensions};
+		tests::throwing_errors const log{};
+		auto const set = distro::versions::read_packages(
+		    distro::manifest_source{manifest, dir.path()}, {}, matcher, log);
+		tests::expect(!set.empty(), "the manifest gives a non-empty set");
+
+		std::vector<distro::StringSet> const architectures{
+		    {}, {"windows-x86_64", "anywhere"}, {"ubuntu18-x86_64"}};
+
+		std::vector<query> queries{};
+		for (auto const& [version, run] : set) {
+			for (auto const& archs : architectures)
+				queries.push_back({version, archs});
+		}
+
+		std::vector<answer> expected{};
+		expected.reserve(queries.size());
+		size_t resolved{};
+		for (auto const& q : queries) {
+			expected.push_back(resolve(set, q));
+			if (!expected.back().archives.empty()) ++resolved;
+		}
+		tests::expect(resolved > queries.size() / 2,
+		              "most of the queries resolve to some archives");
+		std::vector<std::vector<std::vector<std::filesystem::path>>> tables{};
+		for (auto const& archs : architectures)
+			tables.push_back(resolve_all(set, archs));
+
+		static constexpr unsigned thread_count = 8;
+		static constexpr unsigned rounds = 4;
+		std::atomic<size_t> mismatches{0};
+		std::atomic<size_t> answered{0};
+		{
+			std::vector<std::jthread> threads{};
+			for (unsigned thread = 0; thread < thread_count; ++thread) {
+				threads.emplace_back([&, thread] {
+					// every thread walks the queries from a different place
+					auto const count = queries.size();
+					auto const offset = count * thread / thread_count;
+					for (unsigned round = 0; round < rounds; ++round) {
+						for (size_t step = 0; step < count; ++step) {
+							auto const index = (offset + step) % count;
+							auto const got = resolve(set, queries[index]);
+							if (!(got == expected[index])) ++mismatches;
+							++answered;
+						}
+						auto const which = (thread + round) % tables.size();
+						auto const& archs = architectures[which];
+						if (resolve_all(set, archs) != tables[which])
+							++mismatches;
+					}
+				});
+			}
+		}
+
+		tests::expect(answered == queries.size() * thread_count * rounds,
+		              "every thread answered every query");
+		tests::expect(mismatches == 0,
+		              "threads got the single-threaded answers");
+	}
+}  // namespace
+
+int main() {
+	shared_between_threads();
+	return tests::result();
+}